@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Per-pixel convergence of the adaptive sampling.
+// The error is the standard error of the mean luminance, relative to that mean, estimated from
+// the accumulation (sum, count) and the sum of the squared luminance of the samples.
+// Shared between the pixel selection pre-pass and the ray generation. The sums and the moments are
+// only written together, by the trace (render_pixel.glsl) and the reprojection (reproject.comp).
+// Requires: `accumImage`, `momentsImage` and a `rtxState` push constant
+
+
+#ifndef ADAPTIVE_SAMPLING_GLSL
+#define ADAPTIVE_SAMPLING_GLSL 1
+
+float sampleLuminance(vec3 color)
+{
+  return dot(color, vec3(0.212671f, 0.715160f, 0.072169f));
+}
+
+//-----------------------------------------------------------------------
+// Relative standard error of the pixel, negative when the pixel has not
+// enough samples to tell
+//-----------------------------------------------------------------------
+float pixelRelativeError(ivec2 imageCoords)
+{
+  vec4 accum = imageLoad(accumImage, imageCoords);
+  float n    = accum.a;
+  if(n < max(float(rtxState.minPixelSamples), 2.f))
+    return -1.f;
+
+  float mean     = sampleLuminance(accum.rgb) / n;
+  float meanSq   = imageLoad(momentsImage, imageCoords).r / n;
+  float variance = max(meanSq - mean * mean, 0.f) * n / (n - 1.f);  // Unbiased
+
+  // The floor on the mean keeps dark pixels from never converging
+  return sqrt(variance / n) / max(mean, 1e-3f);
+}
+
+bool pixelConverged(float relativeError)
+{
+  return relativeError >= 0.f && relativeError < rtxState.convergenceThreshold;
+}
+
+//-----------------------------------------------------------------------
+// How much a pixel is above the threshold, in [1..maxSampleBoost]
+//-----------------------------------------------------------------------
+float pixelNoiseRatio(float relativeError)
+{
+  if(relativeError < 0.f)
+    return 1.f;
+  return clamp(relativeError / rtxState.convergenceThreshold, 1.f, float(max(rtxState.maxSampleBoost, 1)));
+}
+
+#endif  // ADAPTIVE_SAMPLING_GLSL
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Alpha test of a candidate hit: cutout (alpha mask) and stochastic blending.
+// Shared between the any hit shader and the ray query traversal.
+// Requires: layouts.glsl, random.glsl
+
+
+#ifndef ALPHA_TEST_GLSL
+#define ALPHA_TEST_GLSL 1
+
+
+bool HitIsOpaque(int instanceCustomIndex, int primitiveID, vec2 bary, inout RngStateType seed)
+{
+  // Retrieve the Primitive mesh buffer information
+  InstanceData      pinfo    = geoInfo[instanceCustomIndex];
+  const uint        matIndex = max(0, pinfo.materialIndex);  // material of primitive mesh
+  GltfShadeMaterial mat      = materials[matIndex];
+
+  float baseColorAlpha = mat.pbrBaseColorFactor.a;
+  if(mat.pbrBaseColorTexture > -1)
+  {
+    // Primitive buffer addresses
+    Indices  indices  = Indices(pinfo.indexAddress);
+    Vertices vertices = Vertices(pinfo.vertexAddress);
+
+    // Indices of this triangle primitive.
+    uvec3 tri = indices.i[primitiveID];
+
+    // All vertex attributes of the triangle.
+    VertexAttributes attr0 = vertices.v[tri.x];
+    VertexAttributes attr1 = vertices.v[tri.y];
+    VertexAttributes attr2 = vertices.v[tri.z];
+
+    // Get the texture coordinate
+    const vec3 barycentrics = vec3(1.0 - bary.x - bary.y, bary.x, bary.y);
+    const vec2 uv0          = attr0.texcoord;
+    const vec2 uv1          = attr1.texcoord;
+    const vec2 uv2          = attr2.texcoord;
+    vec2       texcoord0    = uv0 * barycentrics.x + uv1 * barycentrics.y + uv2 * barycentrics.z;
+
+    // Uv Transform
+    texcoord0 = (vec4(texcoord0.xy, 1, 1) * mat.uvTransform).xy;
+
+    baseColorAlpha *= textureLod(texturesMap[nonuniformEXT(mat.pbrBaseColorTexture)], texcoord0, 0).a;
+  }
+
+  float opacity;
+  if(mat.alphaMode == ALPHA_MASK)
+  {
+    opacity = baseColorAlpha > mat.alphaCutoff ? 1.0 : 0.0;
+  }
+  else
+  {
+    opacity = baseColorAlpha;
+  }
+
+  // Do alpha blending the stochastically way
+  return rand(seed) <= opacity;
+}
+
+
+#endif  // ALPHA_TEST_GLSL
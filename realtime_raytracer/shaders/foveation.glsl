@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Eccentricity model of the foveated ray tracing.
+// The eccentricity is the visual angle, in degrees, between the gaze direction and the pixel
+// direction from the eye. With the display geometry (pixel pitch and viewing distance), the
+// rendering region is the physical rectangle seen by the viewer, otherwise the camera frustum.
+// The foveation profile gives the probability and frame interval for each eccentricity, so a
+// profile behaves the same at any display size, field of view and aspect ratio.
+// Shared between the pixel selection pre-pass and the ray generation, so both agree on which
+// pixels are traced in a frame.
+// Requires: random.glsl, the `foveaLut` buffer and a `rtxState` push constant
+
+
+#ifndef FOVEATION_GLSL
+#define FOVEATION_GLSL 1
+
+//-----------------------------------------------------------------------
+// Angle in degrees between the gaze and the pixel, seen from the eye
+//-----------------------------------------------------------------------
+float foveaEccentricity(ivec2 imageCoords, ivec2 imageRes)
+{
+  float aspectRatio = float(imageRes.x) / float(imageRes.y);
+  vec2  tanHalfFov  = vec2(rtxState.tanHalfFovY * aspectRatio, rtxState.tanHalfFovY);
+
+  vec2 pixelNdc = (vec2(imageCoords) + 0.5) / vec2(imageRes) * 2.0 - 1.0;
+  vec2 gazeNdc  = rtxState.gazePosition * 2.0 - 1.0;
+
+  vec3 pixelDir = normalize(vec3(pixelNdc * tanHalfFov, 1.0));
+  vec3 gazeDir  = normalize(vec3(gazeNdc * tanHalfFov, 1.0));
+  return degrees(acos(clamp(dot(pixelDir, gazeDir), -1.0, 1.0)));
+}
+
+FoveaLutEntry foveaLookup(float eccentricity)
+{
+  float t = clamp(eccentricity / rtxState.foveaLutRange, 0.0, 1.0);
+  return foveaLut[int(t * float(FoveaLutSize - 1) + 0.5)];
+}
+
+//-----------------------------------------------------------------------
+// Probability for a pixel to be traced, based on its eccentricity
+//-----------------------------------------------------------------------
+float foveaProbability(float eccentricity)
+{
+  return foveaLookup(eccentricity).probability;
+}
+
+//-----------------------------------------------------------------------
+// Number of frames between two traces of the same pixel, growing with the eccentricity
+//-----------------------------------------------------------------------
+int foveaFrameInterval(float eccentricity)
+{
+  return max(foveaLookup(eccentricity).frameInterval, 1);
+}
+
+//-----------------------------------------------------------------------
+// Radius, in pixels, of the periphery reconstruction kernel. It grows with the
+// average distance between traced pixels: 1/sqrt(probability / interval)
+//-----------------------------------------------------------------------
+float foveaBlurRadius(float eccentricity)
+{
+  FoveaLutEntry entry = foveaLookup(eccentricity);
+  float         rate  = entry.probability / float(max(entry.frameInterval, 1));
+  return clamp(inversesqrt(max(rate, 1e-4)) - 1.0, 0.0, float(PeripheryBlurMaxRadius));
+}
+
+//-----------------------------------------------------------------------
+// Return true if the pixel is traced this frame.
+// probabilityScale raises the chance of noisy pixels in the periphery (adaptive sampling)
+//-----------------------------------------------------------------------
+bool foveaSelectPixel(ivec2 imageCoords, ivec2 imageRes, int frame, float probabilityScale)
+{
+  FoveaLutEntry entry = foveaLookup(foveaEccentricity(imageCoords, imageRes));
+  if(frame % max(entry.frameInterval, 1) != 0)
+    return false;
+
+  uint seed = initRandom(imageRes, imageCoords, uint(frame) ^ rtxState.frameSeed);
+  return rand(seed) <= entry.probability * probabilityScale;
+}
+
+#endif  // FOVEATION_GLSL
@@ -60,6 +60,7 @@ struct PtPayload
   vec2   baryCoord;
   mat4x3 objectToWorld;
   mat4x3 worldToObject;
+  int    hitGroup;  // Material class of the hit (HitGroup_*), from the shader binding table
 };
 
 struct ShadowHitPayload
@@ -167,8 +167,38 @@ void GetSpecularGlossiness(inout State state, in GltfShadeMaterial material)
 
 
 //-----------------------------------------------------------------------
+// Color of an unlit material (KHR_materials_unlit): the base color only,
+// none of the other properties are read
 //-----------------------------------------------------------------------
-void GetMaterialsAndTextures(inout State state, in Ray r)
+vec3 GetUnlitColor(in State state)
+{
+  GltfShadeMaterial material = materials[state.matID];
+  vec2              texCoord = (vec4(state.texCoord.xy, 1, 1) * material.uvTransform).xy;
+
+  vec4 baseColor;
+  if(material.shadingModel == MATERIAL_METALLICROUGHNESS)
+  {
+    baseColor = material.pbrBaseColorFactor;
+    if(material.pbrBaseColorTexture > -1)
+      baseColor *= SRGBtoLINEAR(textureLod(texturesMap[nonuniformEXT(material.pbrBaseColorTexture)], texCoord, 0));
+  }
+  else
+  {
+    baseColor = material.khrDiffuseFactor;
+    if(material.khrDiffuseTexture > -1)
+      baseColor *= SRGBtoLINEAR(textureLod(texturesMap[nonuniformEXT(material.khrDiffuseTexture)], texCoord, 0));
+  }
+  return baseColor.rgb;
+}
+
+
+//-----------------------------------------------------------------------
+// detailTextures: when false, the normal and clearcoat textures are not
+// read and the anisotropy is ignored (periphery of the foveation)
+// transmissive: when false, the transmission is 0 and its texture and the
+// volume are not read (material class without transmission)
+//-----------------------------------------------------------------------
+void GetMaterialsAndTextures(inout State state, in Ray r, bool detailTextures, bool transmissive)
 {
   GltfShadeMaterial material = materials[state.matID];
 
@@ -183,7 +213,7 @@ void GetMaterialsAndTextures(inout State state, in Ray r)
   mat3 TBN       = mat3(state.tangent, state.bitangent, state.normal);
 
   // Perturbating the normal if a normal map is present
-  if(material.normalTexture > -1)
+  if(detailTextures && material.normalTexture > -1)
   {
     vec3 normalVector = textureLod(texturesMap[nonuniformEXT(material.normalTexture)], state.texCoord, 0).xyz;
     normalVector      = normalize(normalVector * 2.0 - 1.0);
@@ -210,8 +240,8 @@ void GetMaterialsAndTextures(inout State state, in Ray r)
 
 
   // KHR_materials_transmission
-  state.mat.transmission = material.transmissionFactor;
-  if(material.transmissionTexture > -1)
+  state.mat.transmission = transmissive ? material.transmissionFactor : 0.0;
+  if(transmissive && material.transmissionTexture > -1)
   {
     state.mat.transmission *= textureLod(texturesMap[nonuniformEXT(material.transmissionTexture)], state.texCoord, 0).r;
   }
@@ -224,32 +254,32 @@ void GetMaterialsAndTextures(inout State state, in Ray r)
   state.mat.unlit = (material.unlit == 1);
 
   // KHR_materials_anisotropy
-  state.mat.anisotropy = material.anisotropy;
+  state.mat.anisotropy = detailTextures ? material.anisotropy : 0.0;
   // Calculate anisotropic roughness along the tangent and bitangent directions
-  float aspect = sqrt(1.0 - material.anisotropy * 0.9);
+  float aspect = sqrt(1.0 - state.mat.anisotropy * 0.9);
   state.mat.ax = max(0.001, state.mat.roughness / aspect);
   state.mat.ay = max(0.001, state.mat.roughness * aspect);
 
   // KHR_materials_anisotropy .. rotates the tangents
-  if(material.anisotropy > 0)
+  if(state.mat.anisotropy > 0)
   {
     state.tangent   = normalize(TBN * material.anisotropyDirection);
     state.bitangent = normalize(cross(state.normal, state.tangent));
   }
 
-  // KHR_materials_volume
-  state.mat.attenuationColor    = material.attenuationColor;
-  state.mat.attenuationDistance = material.attenuationDistance;
-  state.mat.thinwalled          = material.thicknessFactor == 0;
+  // KHR_materials_volume, no absorption without transmission
+  state.mat.attenuationColor    = transmissive ? material.attenuationColor : vec3(1.0);
+  state.mat.attenuationDistance = transmissive ? material.attenuationDistance : INFINITY;
+  state.mat.thinwalled          = !transmissive || material.thicknessFactor == 0;
 
   //KHR_materials_clearcoat
   state.mat.clearcoat          = material.clearcoatFactor;
   state.mat.clearcoatRoughness = material.clearcoatRoughness;
-  if(material.clearcoatTexture > -1)
+  if(detailTextures && material.clearcoatTexture > -1)
   {
     state.mat.clearcoat *= textureLod(texturesMap[nonuniformEXT(material.clearcoatTexture)], state.texCoord, 0).r;
   }
-  if(material.clearcoatRoughnessTexture > -1)
+  if(detailTextures && material.clearcoatRoughnessTexture > -1)
   {
     state.mat.clearcoatRoughness *=
         textureLod(texturesMap[nonuniformEXT(material.clearcoatRoughnessTexture)], state.texCoord, 0).g;
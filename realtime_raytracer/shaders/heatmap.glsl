@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Heatmap debug view: the clock cost (clockARB) of the pixels and of the bounces on each material.
+// The pixel cost is averaged over the last traces in heatmapImage and shown with temperature(),
+// scaled by rtxState.heatmapScale; the per-material sums go to the HeatmapStats buffer, read back
+// by the host. The clocks are per streaming multiprocessor, the costs are only comparable within
+// a trace.
+// Requires: the `heatmapImage`, `heatmapStats` and `resultImage` bindings (layouts.glsl), a
+// `rtxState` push constant and GL_ARB_shader_clock
+
+
+#ifndef HEATMAP_GLSL
+#define HEATMAP_GLSL 1
+
+#include "common.glsl"
+
+
+// Clock of the invocation, only read when the heatmap is on
+uint64_t heatmapClock()
+{
+  return rtxState.heatmap == 1 ? clockARB() : uint64_t(0);
+}
+
+// A bounce hitting the material (-1: the environment) cost the ticks since `start`
+void heatmapMaterial(int material, uint64_t start)
+{
+  if(rtxState.heatmap == 0 || material >= HeatmapMaxMaterials)
+    return;
+
+  uint cost = uint((clockARB() - start) >> HeatmapCostShift);
+  if(material < 0)
+  {
+    atomicAdd(heatmapStats.environment.cost, cost);
+    atomicAdd(heatmapStats.environment.hits, 1u);
+  }
+  else
+  {
+    atomicAdd(heatmapStats.materials[material].cost, cost);
+    atomicAdd(heatmapStats.materials[material].hits, 1u);
+  }
+}
+
+// The pixel cost the ticks since `start`: running average over the last HeatmapWindow traces,
+// replacing the resolved radiance by its temperature
+void heatmapPixel(ivec2 imageCoords, uint64_t start)
+{
+  if(rtxState.heatmap == 0)
+    return;
+
+  float cost  = float(clockARB() - start);
+  vec2  heat  = imageLoad(heatmapImage, imageCoords).rg;
+  heat.g      = min(heat.g + 1, float(HeatmapWindow));
+  heat.r     += (cost - heat.r) / heat.g;
+  imageStore(heatmapImage, imageCoords, vec4(heat, 0, 0));
+
+  atomicMax(heatmapStats.maxPixelCost, uint(heat.r));
+  imageStore(resultImage, imageCoords, vec4(temperature(heat.r * rtxState.heatmapScale), 1.f));
+}
+
+
+#endif  // HEATMAP_GLSL
@@ -66,8 +66,18 @@ END_ENUM();
 
 // Output image - Set 1
 START_ENUM(OutputBindings)
-  eSampler = 0,  // As sampler
-  eStore   = 1   // As storage
+  eSampler      = 0,  // As sampler
+  eStore        = 1,  // As storage
+  ePixelList    = 2,  // Compacted list of pixels to trace
+  eTraceCmd     = 3,  // Indirect trace arguments, width is the number of pixels in the list
+  eAccum        = 4,  // Accumulation, running sum (rgb) and sample count (a), as storage
+  eMoments      = 5,  // Running sum of the squared luminance of the samples, as storage
+  eBlurTemp     = 6,  // Horizontal pass of the periphery reconstruction, as storage
+  eFirstHit     = 7,  // First hit of the accumulated samples: world normal (xyz), distance (w, 0: environment)
+  eHistAccum    = 8,  // Previous frame copy of eAccum, read by the reprojection
+  eHistMoments  = 9,  // Previous frame copy of eMoments
+  eHistFirstHit = 10, // Previous frame copy of eFirstHit
+  eHeatmap      = 11  // Heatmap debug view: average clock cost of the traced pixel (r) and traces in the average (g)
 END_ENUM();
 
 // Scene Data - Set 2
@@ -83,7 +93,24 @@ END_ENUM();
 START_ENUM(EnvBindings)
   eSunSky     = 0, 
   eHdr        = 1, 
-  eImpSamples = 2 
+  eImpSamples = 2,
+  eFoveaLut   = 3,  // Foveation profile, indexed by eccentricity
+  eRayCounters = 4, // Rays and pixels of the trace (RayCounters)
+  eHeatmapStats = 5  // Heatmap debug view: clock cost per material of the trace (HeatmapStats)
+END_ENUM();
+
+// Specialization constants of the trace shaders (layouts.glsl), -1 when not specialized
+START_ENUM(SpecConstants)
+  eSpecPbrMode         = 0,  // RtxState::pbrMode
+  eSpecEnableFoveation = 1,  // RtxState::enableFoveation
+  eSpecMaxDepth        = 2   // RtxState::maxDepth
+END_ENUM();
+
+// Wavefront renderer - Set 4
+START_ENUM(WavefrontBindings)
+  eWfPaths    = 0,  // State of the paths, one per traced pixel
+  eWfQueues   = 1,  // Path indices: extension rays (two, by bounce parity), hits to shade, shadow rays
+  eWfCounters = 2   // Length of the queues and indirect dispatch arguments, per bounce
 END_ENUM();
 
 
@@ -92,6 +119,11 @@ struct SceneCamera
 {
   mat4  viewInverse;
   mat4  projInverse;
+  mat4  viewProj;
+  // Previous frame, for the temporal reprojection
+  mat4  prevViewInverse;
+  mat4  prevProjInverse;
+  mat4  prevViewProj;
   float focalDist;
   float aperture;
   // Extra
@@ -181,8 +213,183 @@ struct RtxState
   ivec2 size;                   // rendering size
   int  enableFoveation;          // Enable foveated raytracing
   int  enablePeripheryBlur;
+  vec2  gazePosition;           // Center of the fovea, normalized [0..1] in the rendering region
+  float tanHalfFovY;            // Half height of the rendering region seen by the eye, to convert pixels to degrees of visual angle
+  float foveaLutRange;          // Eccentricity (degrees) covered by the foveation LUT
+  int   enableAdaptiveSampling; // Stop tracing converged pixels, more samples for the noisy ones
+  float convergenceThreshold;   // Relative standard error of the luminance under which a pixel is converged
+  int   minPixelSamples;        // Samples a pixel needs before its error is estimated
+  int   maxSampleBoost;         // Noisy pixels get up to maxSampleBoost * maxSamples per frame
+  int   enableReprojection;     // Camera motion reprojects the accumulation instead of restarting it
+  int   historyReprojected;     // Set on the frame the history was reprojected, the trace validates it
+  int   maxHistorySamples;      // Samples kept by the reprojection, older ones fade out
+  int   tileSize;               // Tiled trace: side of the tile being traced, 0 when tracing the whole region at once
+  ivec2 tileOrigin;             // Tiled trace: top left pixel of the tile
+  uint  frameSeed;              // Mixed with the frame in the random sequences, set by the camera path playback
+  int   enableRayCounters;      // Counting the rays and pixels of the trace (RayCounters)
+  int   heatmap;                // Debug view: the clock cost of the pixels (heatmap.glsl) instead of the radiance
+  float heatmapScale;           // Heatmap: inverse of the cost shown in red, in clock ticks
+};
+
+// The launch is over the compacted list of the pixels selected by pixel_select.comp, instead of
+// the whole image: with foveation, adaptive sampling, and for the tiles of the tiled trace
+#define LAUNCH_OVER_PIXEL_LIST(state) ((state).enableFoveation == 1 || (state).enableAdaptiveSampling == 1 || (state).tileSize > 0)
+
+// Arguments of vkCmdTraceRaysIndirectKHR (VkTraceRaysIndirectCommandKHR)
+// Filled by the pixel selection pass (pixel_select.comp)
+struct TraceRaysIndirectCmd
+{
+  uint width;      // Number of selected pixels
+  uint height;     // Always 1
+  uint depth;      // Always 1
+  uint nbActive;   // Not part of the command: pixels not converged yet, read back by the host
+  uint dispatchX;  // VkDispatchIndirectCommand of the compute renderer: workgroups over the selected pixels
+  uint dispatchY;  // Always 1
+  uint dispatchZ;  // Always 1
+};
+
+// Workgroup size of the pixel selection compute pass
+const int SelectBlockSize = 16;
+
+// Tiled trace: side of the tiles, a multiple of SelectBlockSize
+const int TraceTileSize = 128;
+
+// Compute renderer (pathtrace.comp): one workgroup per square tile of the image
+const int RayQueryTileSize  = 8;
+const int RayQueryBlockSize = RayQueryTileSize * RayQueryTileSize;
+
+// Foveation profile sampled at regular eccentricities, from 0 to RtxState::foveaLutRange degrees
+struct FoveaLutEntry
+{
+  float probability;    // Chance for a pixel to be traced on the frames it is eligible
+  int   frameInterval;  // Frames between two traces of the same pixel
+  int   maxDepth;       // Path depth limit, 0 to use RtxState::maxDepth
+  float rrFactor;       // Scales the continuation probability of the russian roulette
+  int   pathFlags;      // FoveaPath_xxx
+};
+const int FoveaLutSize = 64;
+
+// Path simplification flags of FoveaLutEntry
+const int FoveaPath_SimpleBsdf = 1;  // Lambert + GGX instead of the Disney or glTF model
+const int FoveaPath_NoDetail   = 2;  // No normal, clearcoat textures and no anisotropy
+
+// Periphery reconstruction (periphery_blur.comp): one line segment per workgroup, and the
+// largest kernel radius, reached where the profile traces the fewest pixels
+const int BlurBlockSize          = 128;
+const int PeripheryBlurMaxRadius = 6;
+
+// Temporal reprojection (reproject.comp): the history is kept where the surface found in the
+// previous frame is the one seen now, within these tolerances
+const int   ReprojectBlockSize       = 16;
+const int   ReprojectIterations      = 3;     // Fixed-point search of the previous pixel
+const float ReprojectPixelTolerance  = 1.0f;  // Round trip error, in pixels
+const float ReprojectDepthTolerance  = 0.05f; // Relative distance difference
+const float ReprojectNormalTolerance = 0.9f;  // Minimum cosine between the normals
+
+// Wavefront renderer (wf_*.comp): the path tracer split in kernels, the paths going from one to
+// the next through queues of path indices. Paths are in the order of the traced pixels.
+const int WfBlockSize    = RayQueryBlockSize;  // Same as the pixel list dispatch (TraceRaysIndirectCmd::dispatchX)
+const int WfMaxBounces   = 16;                 // Counters per bounce, the depth is clamped to it
+const int WfQueue_Extend = 0;                  // Rays to trace
+const int WfQueue_Hit    = 1;                  // Closest hits to shade
+const int WfQueue_Shadow = 2;                  // Shadow rays toward the sampled light
+const int WfQueueRegions = 4;                  // Extension queues of even and odd bounces, hits, shadows
+
+struct WfPath
+{
+  // Ray to trace: written by the generation and the shading, origin of the shadow ray
+  vec3 origin;
+  uint seed;
+  vec3 direction;
+  uint pixel;  // Packed coordinates, as in the pixel list
+  vec3 throughput;
+  int  nbSamples;  // Samples of the pixel this frame
+  vec3 absorption;
+  // Shadow ray, its contribution is added to the sample if not occluded
+  float shadowDist;
+  vec3  shadowDir;
+  float hitT;  // Closest hit, written by the extension for the shading
+  vec3  shadowRadiance;
+  int   primitiveID;
+  vec4  hitTransform[3];  // Object to world, rows
+  vec2  baryCoord;
+  int   instanceID;
+  int   instanceCustomIndex;
+  // Current sample and sum of the samples of the pixel, accumulated by wf_resolve.comp
+  vec3  radiance;
+  float sumLumSquare;
+  vec3  pixelColor;
+  int   hitGroup;  // Material class of the hit (HitGroup_*), written by the extension for the shading
+  vec4  firstHit;
+};
+
+// Length of a queue, and the workgroups to consume it (VkDispatchIndirectCommand)
+struct WfQueueCounter
+{
+  uint count;
+  uint dispatchX;
+  uint dispatchY;
+  uint dispatchZ;
+};
+
+struct WfBounceCounters
+{
+  WfQueueCounter queue[3];  // WfQueue_Extend, WfQueue_Hit, WfQueue_Shadow
 };
 
+// Kernel step, pushed after RtxState
+struct WfStep
+{
+  int sampleIndex;  // Sample pass of the frame, the number of passes for the resolve
+  int bounce;       // Depth of the rays in the queues
+};
+
+// Rays and pixels of a trace, counted by the shaders (ray_counters.glsl), cleared before each
+// trace. The RayCount_xxx constants index the counters in the buffer.
+struct RayCounters
+{
+  uint primary;     // Camera rays
+  uint extension;   // Closest hit rays of the bounces
+  uint shadow;      // Visibility rays toward the sampled lights
+  uint anyHit;      // Any hit invocations: alpha tested candidates of all rays
+  uint pixels;      // Pixels traced
+  uint candidates;  // Pixels the pixel selection considered, 0 without selection
+};
+const int RayCount_Primary    = 0;
+const int RayCount_Extension  = 1;
+const int RayCount_Shadow     = 2;
+const int RayCount_AnyHit     = 3;
+const int RayCount_Pixels     = 4;
+const int RayCount_Candidates = 5;
+
+// Clock cost of the trace per material, for the heatmap debug view (heatmap.glsl). The ticks are
+// added in units of 2^HeatmapCostShift to keep the sums in 32 bits, the materials past
+// HeatmapMaxMaterials are not counted. Cleared before each trace.
+const int HeatmapMaxMaterials = 1024;
+const int HeatmapCostShift    = 8;
+const int HeatmapWindow       = 16;  // Traces in the per-pixel average, the cost follows the camera
+struct HeatmapMaterial
+{
+  uint cost;  // Clock ticks >> HeatmapCostShift, of the bounces hitting the material
+  uint hits;  // Bounces hitting the material
+};
+struct HeatmapStats
+{
+  uint            maxPixelCost;  // Highest average cost of the traced pixels, in clock ticks
+  uint            pad;
+  HeatmapMaterial environment;   // Bounces missing the scene
+  HeatmapMaterial materials[HeatmapMaxMaterials];
+};
+
+// Material classes, one hit group each in the ray tracing pipeline, selected by the
+// instanceShaderBindingTableRecordOffset of the instances (also read by the ray queries). The
+// closest hit is specialized on the class, which the shading uses to skip what the class lacks.
+const int HitGroup_Opaque       = 0;  // Lit, no transmission nor volume
+const int HitGroup_AlphaMask    = 1;  // Any material, with the alpha test any hit (alpha mask or blend)
+const int HitGroup_Transmission = 2;  // Lit, with transmission and volume
+const int HitGroup_Unlit        = 3;  // KHR_materials_unlit: the base color only
+const int HitGroupCount         = 4;
+
 // Structure used for retrieving the primitive information in the closest hit
 // using gl_InstanceCustomIndexNV
 struct InstanceData
@@ -233,7 +440,9 @@ struct Tonemapper
   float saturation;
   float avgLum;
   int   autoExposure;
-
+  int   heatmap;  // The image holds the heatmap debug view, displayed as is
+  vec2  uvScale;  // Dynamic resolution: traced extent over the region extent
+  vec2  uvMax;    // Last texel center of the traced extent
 };
 
 
@@ -37,6 +37,11 @@
 layout(set = S_ACCEL, binding = eTlas)					uniform accelerationStructureEXT topLevelAS;
 //
 layout(set = S_OUT,   binding = eStore)					uniform image2D			resultImage;
+layout(set = S_OUT,   binding = ePixelList,	scalar)		buffer _PixelList		{ uint pixelList[]; };
+layout(set = S_OUT,   binding = eAccum)					uniform image2D			accumImage;
+layout(set = S_OUT,   binding = eMoments)				uniform image2D			momentsImage;
+layout(set = S_OUT,   binding = eFirstHit)				uniform image2D			firstHitImage;
+layout(set = S_OUT,   binding = eHeatmap)				uniform image2D			heatmapImage;
 //
 layout(set = S_SCENE, binding = eInstData,	scalar)     buffer _InstanceInfo	{ InstanceData geoInfo[]; };
 layout(set = S_SCENE, binding = eCamera,	scalar)		uniform _SceneCamera	{ SceneCamera sceneCamera; };
@@ -46,7 +51,10 @@ layout(set = S_SCENE, binding = eTextures	      )		uniform sampler2D		texturesMa
 //
 layout(set = S_ENV, binding = eSunSky,		scalar)		uniform _SSBuffer		{ SunAndSky _sunAndSky; };
 layout(set = S_ENV, binding = eHdr)						uniform sampler2D		environmentTexture;
+layout(set = S_ENV, binding = eFoveaLut,	scalar)		readonly buffer _FoveaLut	{ FoveaLutEntry foveaLut[]; };
 layout(set = S_ENV, binding = eImpSamples,  scalar)		buffer _EnvAccel		{ EnvAccel envSamplingData[]; };
+layout(set = S_ENV, binding = eRayCounters,	scalar)		buffer _RayCounters		{ uint rayCounters[]; };
+layout(set = S_ENV, binding = eHeatmapStats,	scalar)	buffer _HeatmapStats	{ HeatmapStats heatmapStats; };
 
 layout(buffer_reference, scalar) buffer Vertices { VertexAttributes v[]; };
 layout(buffer_reference, scalar) buffer Indices	 { uvec3 i[];            };
@@ -54,4 +62,18 @@ layout(buffer_reference, scalar) buffer Indices	 { uvec3 i[];            };
   // clang-format on
 
 
+//----------------------------------------------
+// Specialization constants
+//----------------------------------------------
+// The pipeline variants (RtxPipeline) bake these settings, the branches of the others are
+// removed by the compiler. Not specialized (-1), the value comes from the `rtxState` push constant.
+layout(constant_id = eSpecPbrMode) const int         specPbrMode         = -1;
+layout(constant_id = eSpecEnableFoveation) const int specEnableFoveation = -1;
+layout(constant_id = eSpecMaxDepth) const int        specMaxDepth        = -1;
+
+#define PBR_MODE (specPbrMode >= 0 ? specPbrMode : rtxState.pbrMode)
+#define ENABLE_FOVEATION (specEnableFoveation >= 0 ? specEnableFoveation : rtxState.enableFoveation)
+#define MAX_DEPTH (specMaxDepth >= 0 ? specMaxDepth : rtxState.maxDepth)
+
+
 #endif  // LAYOUTS_GLSL
@@ -2,6 +2,9 @@
 #define RR 1        // Using russian roulette
 #define RR_DEPTH 0  // Minimum depth
 
+// ClosestHit() and AnyHit() come from traceray_rtx.glsl (ray generation)
+// or traceray_rq.glsl (compute), included before this file, as ray_counters.glsl and heatmap.glsl
+
 
 #include "pbr_disney.glsl"
 #include "pbr_gltf.glsl"
@@ -10,61 +13,19 @@
 #include "env_sampling.glsl"
 #include "shade_state.glsl"
 
+// Path policy of the pixel being traced, set by the ray generation from the eccentricity
+FoveaLutEntry pathPolicy = FoveaLutEntry(1.0, 1, 0, 1.0, 0);
 
+// First hit of the last path: world normal and distance, 0 for the environment (reprojection.glsl)
+vec4 primaryHit = vec4(0);
 
-//-----------------------------------------------------------------------
-// Shoot a ray and return the information of the closest hit, in the
-// PtPayload structure (PRD)
-//
-void ClosestHit(Ray r)
-{
-    uint rayFlags = gl_RayFlagsCullBackFacingTrianglesEXT;
-    prd.hitT = INFINITY;
-    traceRayEXT(topLevelAS,   // acceleration structure
-        rayFlags,     // rayFlags
-        0xFF,         // cullMask
-        0,            // sbtRecordOffset
-        0,            // sbtRecordStride
-        0,            // missIndex
-        r.origin,     // ray origin
-        0.0,          // ray min range
-        r.direction,  // ray direction
-        INFINITY,     // ray max range
-        0             // payload (location = 0)
-    );
-}
-
-
-//-----------------------------------------------------------------------
-// Shadow ray - return true if a ray hits anything
-//
-bool AnyHit(Ray r, float maxDist)
-{
-    shadow_payload.isHit = true;      // Asume hit, will be set to false if hit nothing (miss shader)
-    shadow_payload.seed = prd.seed;  // don't care for the update - but won't affect the rahit shader
-    uint rayFlags = gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsSkipClosestHitShaderEXT | gl_RayFlagsCullBackFacingTrianglesEXT;
-
-    traceRayEXT(topLevelAS,   // acceleration structure
-        rayFlags,     // rayFlags
-        0xFF,         // cullMask
-        0,            // sbtRecordOffset
-        0,            // sbtRecordStride
-        1,            // missIndex
-        r.origin,     // ray origin
-        0.0,          // ray min range
-        r.direction,  // ray direction
-        maxDist,      // ray max range
-        1             // payload layout(location = 1)
-    );
-
-    // add to ray contribution from next event estimation
-    return shadow_payload.isHit;
-}
 
 
 vec3 Eval(in State state, in vec3 V, in vec3 N, in vec3 L, inout float pdf)
 {
-  if(rtxState.pbrMode == 0)
+  if((pathPolicy.pathFlags & FoveaPath_SimpleBsdf) != 0)
+    return PbrSimpleEval(state, V, N, L, pdf);
+  if(PBR_MODE == 0)
     return DisneyEval(state, V, N, L, pdf);
   else
     return PbrEval(state, V, N, L, pdf);
@@ -73,7 +34,9 @@ vec3 Eval(in State state, in vec3 V, in vec3 N, in vec3 L, inout float pdf)
 
 vec3 Sample(in State state, in vec3 V, in vec3 N, inout vec3 L, inout float pdf, inout RngStateType seed)
 {
-  if(rtxState.pbrMode == 0)
+  if((pathPolicy.pathFlags & FoveaPath_SimpleBsdf) != 0)
+    return PbrSimpleSample(state, V, N, L, pdf, seed);
+  if(PBR_MODE == 0)
     return DisneySample(state, V, N, L, pdf, seed);
   else
     return PbrSample(state, V, N, L, pdf, seed);
@@ -186,127 +149,182 @@ VisibilityContribution DirectLight(in Ray r, in State state)
 
 
 //-----------------------------------------------------------------------
+// Radiance of the environment in the direction of a ray that hit nothing
+//
+vec3 EnvironmentRadiance(vec3 direction)
+{
+  vec3 env;
+  if(_sunAndSky.in_use == 1)
+    env = sun_and_sky(_sunAndSky, direction);
+  else
+  {
+    vec2 uv = GetSphericalUv(direction);  // See common.glsl
+    env     = texture(environmentTexture, uv).rgb;
+  }
+  return env * rtxState.hdrMultiplier;
+}
+
+
 //-----------------------------------------------------------------------
-vec3 PathTrace(Ray r)
+// Shading of the hit in `prd`: emission, light sampling, next direction and russian roulette.
+// The ray becomes the next ray of the path. The light contribution is only to be added if the
+// shadow ray toward the light is not occluded: tracing it is left to the caller, so that the
+// wavefront renderer can trace it in another kernel.
+// Returns false when the path ends.
+//
+bool ShadeHit(inout Ray r, int depth, inout vec3 radiance, inout vec3 throughput, inout vec3 absorption, out VisibilityContribution vcontrib)
 {
-  vec3 radiance   = vec3(0.0);
-  vec3 throughput = vec3(1.0);
-  vec3 absorption = vec3(0.0);
+  vcontrib.visible = false;
+
+  BsdfSampleRec bsdfSampleRec;
+
+  // Get Position, Normal, Tangents, Texture Coordinates, Color
+  ShadeState sstate = GetShadeState(prd);
+
+  if(depth == 0)
+    primaryHit = vec4(sstate.normal, prd.hitT);
+
+  State state;
+  state.position       = sstate.position;
+  state.normal         = sstate.normal;
+  state.tangent        = sstate.tangent_u[0];
+  state.bitangent      = sstate.tangent_v[0];
+  state.texCoord       = sstate.text_coords[0];
+  state.matID          = sstate.matIndex;
+  state.isEmitter      = false;
+  state.specularBounce = false;
+  state.isSubsurface   = false;
+  state.ffnormal       = dot(state.normal, r.direction) <= 0.0 ? state.normal : -state.normal;
+
+  // KHR_materials_unlit: the base color only, no material evaluation nor light sampling
+  if(prd.hitGroup == HitGroup_Unlit)
+  {
+    radiance += GetUnlitColor(state) * sstate.color * throughput;
+    return false;
+  }
+
+  // Filling material structures, only the classes that may transmit read the transmission
+  bool transmissive = prd.hitGroup == HitGroup_Transmission || prd.hitGroup == HitGroup_AlphaMask;
+  GetMaterialsAndTextures(state, r, (pathPolicy.pathFlags & FoveaPath_NoDetail) == 0, transmissive);
 
-  for(int depth = 0; depth < rtxState.maxDepth; depth++)
+  // Color at vertices
+  state.mat.albedo *= sstate.color;
+
+  // KHR_materials_unlit, alpha tested
+  if(state.mat.unlit)
   {
-    ClosestHit(r);
+    radiance += state.mat.albedo * throughput;
+    return false;
+  }
 
-    // Hitting the environment
-    if(prd.hitT == INFINITY)
-    {
-      vec3 env;
-      if(_sunAndSky.in_use == 1)
-        env = sun_and_sky(_sunAndSky, r.direction);
-      else
-      {
-        vec2 uv = GetSphericalUv(r.direction);  // See common.glsl
-        env     = texture(environmentTexture, uv).rgb;
-      }
-      // Done sampling return
-      return radiance + (env * rtxState.hdrMultiplier * throughput);
-    }
+  // Reset absorption when ray is going out of surface
+  if(dot(state.normal, state.ffnormal) > 0.0)
+  {
+    absorption = vec3(0.0);
+  }
 
+  // Emissive material
+  radiance += state.mat.emission * throughput;
 
-    BsdfSampleRec bsdfSampleRec;
+  // Add absoption (transmission / volume)
+  throughput *= exp(-absorption * prd.hitT);
 
-    // Get Position, Normal, Tangents, Texture Coordinates, Color
-    ShadeState sstate = GetShadeState(prd);
+  // Light and environment contribution
+  VisibilityContribution lightContrib = DirectLight(r, state);
+  lightContrib.radiance *= throughput;
 
-    State state;
-    state.position       = sstate.position;
-    state.normal         = sstate.normal;
-    state.tangent        = sstate.tangent_u[0];
-    state.bitangent      = sstate.tangent_v[0];
-    state.texCoord       = sstate.text_coords[0];
-    state.matID          = sstate.matIndex;
-    state.isEmitter      = false;
-    state.specularBounce = false;
-    state.isSubsurface   = false;
-    state.ffnormal       = dot(state.normal, r.direction) <= 0.0 ? state.normal : -state.normal;
+  // Sampling for the next ray
+  bsdfSampleRec.f = Sample(state, -r.direction, state.ffnormal, bsdfSampleRec.L, bsdfSampleRec.pdf, prd.seed);
 
-    // Filling material structures
-    GetMaterialsAndTextures(state, r);
+  // Set absorption only if the ray is currently inside the object.
+  if(dot(state.ffnormal, bsdfSampleRec.L) < 0.0)
+  {
+    absorption = -log(state.mat.attenuationColor) / vec3(state.mat.attenuationDistance);
+  }
 
-    // Color at vertices
-    state.mat.albedo *= sstate.color;
+  if(bsdfSampleRec.pdf > 0.0)
+  {
+    throughput *= bsdfSampleRec.f * abs(dot(state.ffnormal, bsdfSampleRec.L)) / bsdfSampleRec.pdf;
+  }
+  else
+  {
+    return false;
+  }
 
-    // KHR_materials_unlit
-    if(state.mat.unlit)
-    {
-      return radiance + state.mat.albedo * throughput;
-    }
+  vcontrib = lightContrib;
 
-    // Reset absorption when ray is going out of surface
-    if(dot(state.normal, state.ffnormal) > 0.0)
-    {
-      absorption = vec3(0.0);
-    }
+#ifdef RR
+  // For Russian-Roulette (minimizing live state)
+  float rrPcont = (depth >= RR_DEPTH) ?
+                      min(max(throughput.x, max(throughput.y, throughput.z)) * state.eta * state.eta + 0.001, 0.95)
+                          * pathPolicy.rrFactor :
+                      1.0;
+#endif
 
-    // Emissive material
-    radiance += state.mat.emission * throughput;
+  // Next ray
+  r.direction = bsdfSampleRec.L;
+  r.origin    = OffsetRay(sstate.position, dot(bsdfSampleRec.L, state.ffnormal) > 0 ? state.ffnormal : -state.ffnormal);
 
-    // Add absoption (transmission / volume)
-    throughput *= exp(-absorption * prd.hitT);
+#ifdef RR
+  // The shadow ray does not use the seed, the roulette can be decided before tracing it
+  if(rand(prd.seed) >= rrPcont)
+    return false;           // paths with low throughput that won't contribute
+  throughput /= rrPcont;  // boost the energy of the non-terminated paths
+#endif
 
-    // Light and environment contribution
-    VisibilityContribution vcontrib = DirectLight(r, state);
-    vcontrib.radiance *= throughput;
+  return true;
+}
 
-    // Sampling for the next ray
-    bsdfSampleRec.f = Sample(state, -r.direction, state.ffnormal, bsdfSampleRec.L, bsdfSampleRec.pdf, prd.seed);
 
-    // Set absorption only if the ray is currently inside the object.
-    if(dot(state.ffnormal, bsdfSampleRec.L) < 0.0)
-    {
-      absorption = -log(state.mat.attenuationColor) / vec3(state.mat.attenuationDistance);
-    }
+//-----------------------------------------------------------------------
+//-----------------------------------------------------------------------
+vec3 PathTrace(Ray r)
+{
+  vec3 radiance   = vec3(0.0);
+  vec3 throughput = vec3(1.0);
+  vec3 absorption = vec3(0.0);
 
-    if(bsdfSampleRec.pdf > 0.0)
-    {
-      throughput *= bsdfSampleRec.f * abs(dot(state.ffnormal, bsdfSampleRec.L)) / bsdfSampleRec.pdf;
-    }
-    else
-    {
-      break;
-    }
+  int maxDepth = pathPolicy.maxDepth > 0 ? min(pathPolicy.maxDepth, MAX_DEPTH) : MAX_DEPTH;
+  for(int depth = 0; depth < maxDepth; depth++)
+  {
+    // Heatmap: the cost of the bounce, from its ray to its shadow ray, goes to the material hit
+    uint64_t bounceStart = heatmapClock();
 
+    countRay(depth == 0 ? RayCount_Primary : RayCount_Extension);
+    ClosestHit(r);
 
-#ifdef RR
-    // For Russian-Roulette (minimizing live state)
-    float rrPcont = (depth >= RR_DEPTH) ?
-                        min(max(throughput.x, max(throughput.y, throughput.z)) * state.eta * state.eta + 0.001, 0.95) :
-                        1.0;
-#endif
+    // Hitting the environment
+    if(prd.hitT == INFINITY)
+    {
+      if(depth == 0)
+        primaryHit = vec4(0);
+
+      // Done sampling return
+      radiance += EnvironmentRadiance(r.direction) * throughput;
+      heatmapMaterial(-1, bounceStart);
+      return radiance;
+    }
 
-    // Next ray
-    r.direction = bsdfSampleRec.L;
-    r.origin = OffsetRay(sstate.position, dot(bsdfSampleRec.L, state.ffnormal) > 0 ? state.ffnormal : -state.ffnormal);
+    VisibilityContribution vcontrib;
+    bool                   continuePath = ShadeHit(r, depth, radiance, throughput, absorption, vcontrib);
 
     // We are adding the contribution to the radiance only if the ray is not occluded by an object.
     // This is done here to minimize live state across ray-trace calls.
     if(vcontrib.visible == true)
     {
       // Shoot shadow ray up to the light (1e32 == environement)
-      Ray  shadowRay = Ray(r.origin, vcontrib.lightDir);
-      bool inShadow  = AnyHit(shadowRay, vcontrib.lightDist);
+      Ray shadowRay = Ray(r.origin, vcontrib.lightDir);
+      countRay(RayCount_Shadow);
+      bool inShadow = AnyHit(shadowRay, vcontrib.lightDist);
       if(!inShadow)
       {
         radiance += vcontrib.radiance;
       }
     }
+    heatmapMaterial(max(0, geoInfo[prd.instanceCustomIndex].materialIndex), bounceStart);
 
-
-#ifdef RR
-    if(rand(prd.seed) >= rrPcont)
-      break;                // paths with low throughput that won't contribute
-    throughput /= rrPcont;  // boost the energy of the non-terminated paths
-#endif
+    if(!continuePath)
+      break;
   }
 
 
@@ -314,7 +332,8 @@ vec3 PathTrace(Ray r)
 }
 
 
-vec3 samplePixel(ivec2 imageCoords, ivec2 sizeImage)
+// Camera ray through a random position of the pixel
+Ray CameraRay(ivec2 imageCoords, ivec2 sizeImage)
 {
     // Compute ray origin using the camera's inverse view matrix.
     vec4 origin = sceneCamera.viewInverse * vec4(0, 0, 0, 1);
@@ -331,12 +350,12 @@ vec3 samplePixel(ivec2 imageCoords, ivec2 sizeImage)
     vec3 direction = normalize((sceneCamera.viewInverse * vec4(targetInFrustum.xyz, 0)).xyz);
 
     // Create a ray with the calculated origin and direction.
-    Ray ray = Ray(origin.xyz, direction);
-
-    // Calculate the color contribution from the ray.
-    vec3 radiance = PathTrace(ray);
+    return Ray(origin.xyz, direction);
+}
 
-    // Firefly removal: Clamp extremely bright pixels to reduce noise.
+// Firefly removal: Clamp extremely bright pixels to reduce noise.
+vec3 ClampFirefly(vec3 radiance)
+{
     float luminance = dot(radiance, vec3(0.212671f, 0.715160f, 0.072169f));
     if (luminance > rtxState.fireflyClampThreshold)
     {
@@ -345,3 +364,11 @@ vec3 samplePixel(ivec2 imageCoords, ivec2 sizeImage)
 
     return radiance;
 }
+
+vec3 samplePixel(ivec2 imageCoords, ivec2 sizeImage)
+{
+    // Calculate the color contribution from the ray.
+    vec3 radiance = PathTrace(CameraRay(imageCoords, sizeImage));
+
+    return ClampFirefly(radiance);
+}
@@ -553,4 +553,76 @@ vec3 PbrSample(in State state, vec3 V, vec3 N, inout vec3 L, inout float pdf, in
   return brdf;
 }
 
+
+//-----------------------------------------------------------------------
+// Simplified material of the periphery: Lambert + isotropic GGX only.
+// No clearcoat, sheen or anisotropy; transmission uses the full model.
+//-----------------------------------------------------------------------
+vec3 PbrSimpleEval(in State state, vec3 V, vec3 N, vec3 L, inout float pdf)
+{
+  if(state.mat.transmission > 0.0)
+    return PbrEval(state, V, N, L, pdf);
+
+  pdf = 0.0;
+  if(dot(N, L) < 0.0)
+    return vec3(0.0);
+
+  state.mat.anisotropy = 0;
+  vec3 H               = normalize(L + V);
+
+  float diffuseRatio  = 0.5 * (1.0 - state.mat.metallic);
+  float specularRatio = 1.0 - diffuseRatio;
+  float reflectance   = max(max(state.mat.f0.r, state.mat.f0.g), state.mat.f0.b);
+  vec3  f0            = state.mat.f0;
+  vec3  f90           = vec3(clamp(reflectance * 50.0, 0.0, 1.0));
+
+  float diffusePdf;
+  float specularPdf;
+  vec3  brdf = EvalDiffuseGltf(state, f0, f90, V, N, L, H, diffusePdf);
+  brdf += EvalSpecularGltf(state, f0, f90, V, N, L, H, specularPdf);
+  pdf = diffusePdf * diffuseRatio + specularPdf * specularRatio;
+
+  return brdf;
+}
+
+vec3 PbrSimpleSample(in State state, vec3 V, vec3 N, inout vec3 L, inout float pdf, inout RngStateType seed)
+{
+  if(state.mat.transmission > 0.0)
+    return PbrSample(state, V, N, L, pdf, seed);
+
+  state.mat.anisotropy = 0;
+
+  float diffuseRatio  = 0.5 * (1.0 - state.mat.metallic);
+  float specularRatio = 1.0 - diffuseRatio;
+  float reflectance   = max(max(state.mat.f0.r, state.mat.f0.g), state.mat.f0.b);
+  vec3  f0            = state.mat.f0;
+  vec3  f90           = vec3(clamp(reflectance * 50.0, 0.0, 1.0));
+
+  float r1 = rand(seed);
+  float r2 = rand(seed);
+  vec3  T  = state.tangent;
+  vec3  B  = state.bitangent;
+
+  vec3 brdf;
+  if(rand(seed) < diffuseRatio)
+  {
+    L = CosineSampleHemisphere(r1, r2);
+    L = L.x * T + L.y * B + L.z * N;
+
+    brdf = EvalDiffuseGltf(state, f0, f90, V, N, L, normalize(L + V), pdf);
+    pdf *= diffuseRatio;
+  }
+  else
+  {
+    vec3 H = GgxSampling(state.mat.roughness, r1, r2);
+    H      = T * H.x + B * H.y + N * H.z;
+    L      = reflect(-V, H);
+
+    brdf = EvalSpecularGltf(state, f0, f90, V, N, L, H, pdf);
+    pdf *= specularRatio;
+  }
+
+  return brdf;
+}
+
 #endif  // PBR_GLTF_GLSL
@@ -11,7 +11,7 @@
 layout(location = 0) in vec2 uvCoords;
 layout(location = 0) out vec4 fragColor;
 
-layout(set = 0, binding = 0) uniform sampler2D inImage;
+layout(set = 0, binding = eSampler) uniform sampler2D inImage;
 
 layout(push_constant) uniform _Tonemapper
 {
@@ -81,8 +81,18 @@ vec3 toneMap(vec3 color, float u_Exposure)
 
 void main()
 {
-  // ray tracing output image
-  vec4 hdr = texture(inImage, uvCoords).rgba;
+  // ray tracing output image: accumulation resolved by the ray generation, or reconstructed
+  // by the periphery pass. Dynamic resolution: the traced extent is upscaled (bilinear) to the
+  // region, without filtering in the texels beyond it.
+  vec2 uv  = min(uvCoords * tm.uvScale, tm.uvMax);
+  vec4 hdr = texture(inImage, uv).rgba;
+
+  // Debug view: the temperature colors of the heatmap are not tonemapped
+  if(tm.heatmap == 1)
+  {
+    fragColor = vec4(hdr.rgb, 1.f);
+    return;
+  }
 
   if(tm.autoExposure == 1)
   {
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Counting the rays and pixels of the trace (RayCounters), one atomic per subgroup and counter.
+// Requires: the `rayCounters` buffer (layouts.glsl), a `rtxState` push constant and
+// GL_KHR_shader_subgroup_ballot
+
+
+#ifndef RAY_COUNTERS_GLSL
+#define RAY_COUNTERS_GLSL 1
+
+
+// Adding one for the invocation. The active invocations counting the same thing are summed by a
+// ballot, each pass of the loop handles the counter of the first one left.
+void countRay(int counter)
+{
+  if(rtxState.enableRayCounters == 0)
+    return;
+
+  for(;;)
+  {
+    if(subgroupBroadcastFirst(counter) == counter)
+    {
+      uint count = subgroupBallotBitCount(subgroupBallot(true));
+      if(subgroupElect())
+        atomicAdd(rayCounters[counter], count);
+      break;
+    }
+  }
+}
+
+
+#endif  // RAY_COUNTERS_GLSL
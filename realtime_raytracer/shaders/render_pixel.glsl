@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Path tracing of one pixel and its accumulation: samples, moments, first hit for the
+// reprojection and resolved value. Shared by the ray generation (pathtrace.rgen) and the
+// compute renderer (pathtrace.comp), which only differ in how rays are traced. The wavefront
+// renderer (wf_*.comp) only uses the sample count and the accumulation.
+// Requires: pathtrace.glsl, adaptive_sampling.glsl, foveation.glsl, reprojection.glsl, ray_counters.glsl, heatmap.glsl
+
+
+#ifndef RENDER_PIXEL_GLSL
+#define RENDER_PIXEL_GLSL 1
+
+
+// Number of samples of the pixel this frame. Adaptive sampling: the noisier, the more samples.
+int pixelSampleCount(ivec2 imageCoords)
+{
+  if(rtxState.enableAdaptiveSampling == 1)
+    return int(ceil(float(rtxState.maxSamples) * pixelNoiseRatio(pixelRelativeError(imageCoords))));
+  return rtxState.maxSamples;
+}
+
+
+// Adding the samples of this frame to the accumulation of the pixel
+void accumulatePixel(ivec2 imageCoords, vec3 pixelColor, float sumLumSquare, vec4 firstHit, int nbSamples)
+{
+  vec4  accum  = imageLoad(accumImage, imageCoords);
+  float moment = imageLoad(momentsImage, imageCoords).r;
+
+  // Temporal reprojection: the history moved to this pixel is dropped if it is not the
+  // surface hit now, a disocclusion the reprojection pass could not see
+  if(rtxState.historyReprojected == 1 && accum.a > 0 && !sameSurface(imageLoad(firstHitImage, imageCoords), firstHit))
+  {
+    accum  = vec4(0);
+    moment = 0;
+  }
+  imageStore(firstHitImage, imageCoords, firstHit);
+
+  // Accumulation over time: every sample counts with the same weight, whatever the number
+  // of frames the pixel was skipped. The buffer is cleared when the frame restarts.
+  accum += vec4(pixelColor, float(nbSamples));
+  imageStore(accumImage, imageCoords, accum);
+
+  // Second moment, for the variance estimate of the adaptive sampling
+  imageStore(momentsImage, imageCoords, vec4(moment + sumLumSquare));
+
+  // Resolved value, displayed by the tonemapper. The periphery reconstruction overwrites it.
+  imageStore(resultImage, imageCoords, vec4(accum.rgb / accum.a, 1.f));
+}
+
+
+void renderPixel(ivec2 imageCoords, ivec2 imageRes)
+{
+  uint64_t pixelStart = heatmapClock();
+  countRay(RayCount_Pixels);
+
+  // Initialize the seed for the random number
+  prd.seed = initRandom(imageRes, imageCoords, uint(rtxState.frame) ^ rtxState.frameSeed);
+
+  // Depth, russian roulette and material simplification of the path, from the eccentricity
+  if(ENABLE_FOVEATION == 1)
+    pathPolicy = foveaLookup(foveaEccentricity(imageCoords, imageRes));
+
+  int nbSamples = pixelSampleCount(imageCoords);
+
+  vec3  pixelColor   = vec3(0);
+  float sumLumSquare = 0;
+  vec4  firstHit     = vec4(0);
+  for(int smpl = 0; smpl < nbSamples; ++smpl)
+  {
+    vec3 radiance = samplePixel(imageCoords, imageRes);
+    float lum     = sampleLuminance(radiance);
+    pixelColor   += radiance;
+    sumLumSquare += lum * lum;
+    if(smpl == 0)
+      firstHit = primaryHit;
+  }
+
+  accumulatePixel(imageCoords, pixelColor, sumLumSquare, firstHit, nbSamples);
+  heatmapPixel(imageCoords, pixelStart);
+}
+
+
+#endif  // RENDER_PIXEL_GLSL
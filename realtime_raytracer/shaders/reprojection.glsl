@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Temporal reprojection of the accumulation under camera motion.
+// A first hit is the world normal (xyz) and the distance (w) of the surface seen through a pixel,
+// a distance of 0 being the environment, which is at infinity and only has a direction.
+// Shared between the reprojection pass and the ray generation, which validates the history
+// against the surface it actually hits.
+// Requires: host_device.h
+
+
+#ifndef REPROJECTION_GLSL
+#define REPROJECTION_GLSL 1
+
+
+//-----------------------------------------------------------------------
+// Direction of the camera ray through a position in the image, as samplePixel()
+//-----------------------------------------------------------------------
+vec3 cameraRayDirection(mat4 viewInverse, mat4 projInverse, vec2 pixel, ivec2 size)
+{
+  vec2 uv              = pixel / vec2(size) * 2.0 - 1.0;
+  vec4 targetInFrustum = projInverse * vec4(uv.x, uv.y, 1, 1);
+  return normalize((viewInverse * vec4(targetInFrustum.xyz, 0)).xyz);
+}
+
+//-----------------------------------------------------------------------
+// Position in the image of the first hit along a ray, false when behind the camera
+//-----------------------------------------------------------------------
+bool projectToPixel(mat4 viewProj, vec3 origin, vec3 direction, float dist, ivec2 size, out vec2 pixel)
+{
+  vec4 clip = dist > 0 ? viewProj * vec4(origin + direction * dist, 1) : viewProj * vec4(direction, 0);
+  pixel     = (clip.xy / clip.w * 0.5 + 0.5) * vec2(size);
+  return clip.w > 0;
+}
+
+//-----------------------------------------------------------------------
+// Both first hits are the environment, or the same surface within the
+// depth and normal tolerances
+//-----------------------------------------------------------------------
+bool sameSurface(vec4 hitA, vec4 hitB)
+{
+  if(hitA.w <= 0 || hitB.w <= 0)
+    return hitA.w <= 0 && hitB.w <= 0;
+
+  return abs(hitA.w - hitB.w) <= ReprojectDepthTolerance * hitB.w && dot(hitA.xyz, hitB.xyz) >= ReprojectNormalTolerance;
+}
+
+
+#endif  // REPROJECTION_GLSL
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Tracing with ray queries, for the compute renderer (pathtrace.comp). Same results as
+// traceray_rtx.glsl: the traversal loop does the alpha test of the any hit shader and the
+// committed intersection fills the payload as the closest hit shader does.
+// Requires: the `prd` payload variable, layouts.glsl, random.glsl, alpha_test.glsl and
+// ray_counters.glsl
+
+
+#ifndef TRACERAY_RQ_GLSL
+#define TRACERAY_RQ_GLSL 1
+
+
+//-----------------------------------------------------------------------
+// Shoot a ray and return the information of the closest hit, in the
+// PtPayload structure (PRD)
+//
+void ClosestHit(Ray r)
+{
+  uint rayFlags = gl_RayFlagsCullBackFacingTrianglesEXT;
+  prd.hitT      = INFINITY;
+
+  rayQueryEXT rayQuery;
+  rayQueryInitializeEXT(rayQuery, topLevelAS, rayFlags, 0xFF, r.origin, 0.0, r.direction, INFINITY);
+
+  while(rayQueryProceedEXT(rayQuery))
+  {
+    // Non-opaque geometry: the job of the any hit shader
+    countRay(RayCount_AnyHit);
+    if(HitIsOpaque(rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false),
+                   rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false),
+                   rayQueryGetIntersectionBarycentricsEXT(rayQuery, false), prd.seed))
+      rayQueryConfirmIntersectionEXT(rayQuery);
+  }
+
+  if(rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionNoneEXT)
+    return;
+
+  // The job of the closest hit shader
+  prd.hitT                = rayQueryGetIntersectionTEXT(rayQuery, true);
+  prd.primitiveID         = rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, true);
+  prd.instanceID          = rayQueryGetIntersectionInstanceIdEXT(rayQuery, true);
+  prd.instanceCustomIndex = rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, true);
+  prd.baryCoord           = rayQueryGetIntersectionBarycentricsEXT(rayQuery, true);
+  prd.objectToWorld       = rayQueryGetIntersectionObjectToWorldEXT(rayQuery, true);
+  prd.worldToObject       = rayQueryGetIntersectionWorldToObjectEXT(rayQuery, true);
+  prd.hitGroup            = int(rayQueryGetIntersectionInstanceShaderBindingTableRecordOffsetEXT(rayQuery, true));
+}
+
+
+//-----------------------------------------------------------------------
+// Shadow ray - return true if a ray hits anything
+//
+bool AnyHit(Ray r, float maxDist)
+{
+  uint rayFlags = gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsCullBackFacingTrianglesEXT;
+
+  rayQueryEXT rayQuery;
+  rayQueryInitializeEXT(rayQuery, topLevelAS, rayFlags, 0xFF, r.origin, 0.0, r.direction, maxDist);
+
+  // Don't care for the update of the seed, as the shadow payload of the pipeline version
+  RngStateType seed = prd.seed;
+  while(rayQueryProceedEXT(rayQuery))
+  {
+    countRay(RayCount_AnyHit);
+    if(HitIsOpaque(rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false),
+                   rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false),
+                   rayQueryGetIntersectionBarycentricsEXT(rayQuery, false), seed))
+      rayQueryConfirmIntersectionEXT(rayQuery);
+  }
+
+  return rayQueryGetIntersectionTypeEXT(rayQuery, true) != gl_RayQueryCommittedIntersectionNoneEXT;
+}
+
+
+#endif  // TRACERAY_RQ_GLSL
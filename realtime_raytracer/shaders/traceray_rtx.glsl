@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Tracing with the ray tracing pipeline: the closest hit shader fills the payload and the
+// any hit shader does the alpha test. See traceray_rq.glsl for the ray query version.
+// Requires: the `prd` and `shadow_payload` ray payloads
+
+
+#ifndef TRACERAY_RTX_GLSL
+#define TRACERAY_RTX_GLSL 1
+
+
+//-----------------------------------------------------------------------
+// Shoot a ray and return the information of the closest hit, in the
+// PtPayload structure (PRD)
+//
+void ClosestHit(Ray r)
+{
+    uint rayFlags = gl_RayFlagsCullBackFacingTrianglesEXT;
+    prd.hitT = INFINITY;
+    traceRayEXT(topLevelAS,   // acceleration structure
+        rayFlags,     // rayFlags
+        0xFF,         // cullMask
+        0,            // sbtRecordOffset
+        0,            // sbtRecordStride
+        0,            // missIndex
+        r.origin,     // ray origin
+        0.0,          // ray min range
+        r.direction,  // ray direction
+        INFINITY,     // ray max range
+        0             // payload (location = 0)
+    );
+}
+
+
+//-----------------------------------------------------------------------
+// Shadow ray - return true if a ray hits anything
+//
+bool AnyHit(Ray r, float maxDist)
+{
+    shadow_payload.isHit = true;      // Asume hit, will be set to false if hit nothing (miss shader)
+    shadow_payload.seed = prd.seed;  // don't care for the update - but won't affect the rahit shader
+    uint rayFlags = gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsSkipClosestHitShaderEXT | gl_RayFlagsCullBackFacingTrianglesEXT;
+
+    traceRayEXT(topLevelAS,   // acceleration structure
+        rayFlags,     // rayFlags
+        0xFF,         // cullMask
+        0,            // sbtRecordOffset
+        0,            // sbtRecordStride
+        1,            // missIndex
+        r.origin,     // ray origin
+        0.0,          // ray min range
+        r.direction,  // ray direction
+        maxDist,      // ray max range
+        1             // payload layout(location = 1)
+    );
+
+    // add to ray contribution from next event estimation
+    return shadow_payload.isHit;
+}
+
+
+#endif  // TRACERAY_RTX_GLSL
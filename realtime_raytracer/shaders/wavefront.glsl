@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront renderer: paths, queues and their counters, shared by the wf_*.comp kernels.
+// A kernel consumes the queue of its bounce, one invocation per path index, and appends the
+// paths going to the next kernel with one atomic per subgroup.
+// Requires: layouts.glsl, pathtrace.glsl, adaptive_sampling.glsl, a `wfStep` push constant and
+// GL_KHR_shader_subgroup_ballot
+
+
+#ifndef WAVEFRONT_GLSL
+#define WAVEFRONT_GLSL 1
+
+
+// clang-format off
+layout(set = S_WF, binding = eWfPaths,    scalar)  buffer _WfPaths     { WfPath paths[]; };
+layout(set = S_WF, binding = eWfQueues,   scalar)  buffer _WfQueues    { uint queues[]; };
+layout(set = S_WF, binding = eWfCounters, scalar)  buffer _WfCounters  { WfBounceCounters counters[]; };
+// clang-format on
+
+
+// Start of the queue in `queues`, each region holds the index of all paths
+uint wfQueueOffset(int bounce, int queue)
+{
+  uint region   = queue == WfQueue_Extend ? uint(bounce & 1) : uint(queue + 1);
+  uint capacity = uint(rtxState.size.x * rtxState.size.y);
+  return region * capacity;
+}
+
+// Path index of the invocation in the queue of the current bounce, false past its end
+bool wfQueueLoad(int queue, out uint pathIndex)
+{
+  uint slot = gl_GlobalInvocationID.x;
+  if(slot >= counters[wfStep.bounce].queue[queue].count)
+    return false;
+  pathIndex = queues[wfQueueOffset(wfStep.bounce, queue) + slot];
+  return true;
+}
+
+// Appending the path to a queue, the first active invocation reserves the slots of the subgroup
+// and grows the indirect dispatch of the consumer
+void wfQueuePush(int bounce, int queue, uint pathIndex)
+{
+  uvec4 ballot = subgroupBallot(true);
+  uint  count  = subgroupBallotBitCount(ballot);
+  uint  base   = 0;
+  if(subgroupElect())
+  {
+    base = atomicAdd(counters[bounce].queue[queue].count, count);
+    atomicMax(counters[bounce].queue[queue].dispatchX, (base + count + WfBlockSize - 1) / WfBlockSize);
+  }
+  base = subgroupBroadcastFirst(base);
+  queues[wfQueueOffset(bounce, queue) + base + subgroupBallotExclusiveBitCount(ballot)] = pathIndex;
+}
+
+ivec2 wfPixelCoords(uint pathIndex)
+{
+  uint packedCoords = paths[pathIndex].pixel;
+  return ivec2(packedCoords & 0xFFFF, packedCoords >> 16);
+}
+
+// Adding the sample traced by the previous pass to the pixel sums
+void wfFinishSample(uint pathIndex, int sampleIndex)
+{
+  if(sampleIndex == 0 || sampleIndex > paths[pathIndex].nbSamples)
+    return;
+
+  vec3  radiance = ClampFirefly(paths[pathIndex].radiance);
+  float lum      = sampleLuminance(radiance);
+  paths[pathIndex].pixelColor += radiance;
+  paths[pathIndex].sumLumSquare += lum * lum;
+}
+
+
+#endif  // WAVEFRONT_GLSL
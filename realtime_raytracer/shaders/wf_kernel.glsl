@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront renderer: preamble of the wf_*.comp kernels, after their `#version`.
+// Extensions, descriptor layouts, the path state of the invocation, the push constant (RtxState
+// and the WfStep of the dispatch) and the path tracing functions. Only portable extensions: the
+// kernels run on any device with ray queries.
+
+
+#ifndef WF_KERNEL_GLSL
+#define WF_KERNEL_GLSL 1
+
+#extension GL_EXT_ray_query : require                   // Tracing from compute
+#extension GL_KHR_shader_subgroup_basic : require       // Subgroup size and invocation index
+#extension GL_KHR_shader_subgroup_ballot : require      // Appending to the queues, one atomic per subgroup
+#extension GL_EXT_scalar_block_layout : enable          // Align structure layout to scalar
+#extension GL_EXT_nonuniform_qualifier : enable         // To access unsized descriptor arrays
+#extension GL_ARB_shader_clock : enable                 // Using clockARB
+#extension GL_EXT_shader_image_load_formatted : enable  // The folowing extension allow to pass images as function parameters
+
+#extension GL_ARB_gpu_shader_int64 : enable       // Debug - heatmap value
+#extension GL_EXT_shader_realtime_clock : enable  // Debug - heatmap timing
+
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#extension GL_EXT_buffer_reference2 : require
+
+#include "host_device.h"
+
+#include "globals.glsl"
+#include "layouts.glsl"
+
+layout(local_size_x = WfBlockSize) in;
+
+// Not a ray payload: the state of the path being processed
+PtPayload prd;
+
+layout(push_constant) uniform _RtxState
+{
+  RtxState rtxState;
+  WfStep   wfStep;
+};
+
+
+#include "ray_counters.glsl"
+#include "heatmap.glsl"
+#include "random.glsl"
+#include "alpha_test.glsl"
+#include "traceray_rq.glsl"
+#include "pathtrace.glsl"
+#include "common.glsl"
+#include "adaptive_sampling.glsl"
+#include "foveation.glsl"
+#include "reprojection.glsl"
+#include "render_pixel.glsl"
+#include "wavefront.glsl"
+
+#endif  // WF_KERNEL_GLSL
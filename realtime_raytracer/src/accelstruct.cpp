@@ -4,6 +4,7 @@
 #include "shaders/host_device.h"
 #include "tools.hpp"
 
+#include <array>
 #include <sstream>
 #include <ios>
 
@@ -95,10 +96,27 @@ void AccelStructure::createBottomLevelAS(nvh::GltfScene&                  gltfSc
                                      | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Class of the material, which is the hit group of the instances using it. The alpha tested
+// materials need the any hit whatever their class, they are shaded as any material.
+//
+int AccelStructure::materialHitGroup(const nvh::GltfMaterial& mat)
+{
+  // Always opaque, no need to use anyhit (faster)
+  if(!(mat.alphaMode == 0 || (mat.baseColorFactor.w == 1.0f && mat.baseColorTexture == -1)))
+    return HitGroup_AlphaMask;
+  if(mat.unlit.active)
+    return HitGroup_Unlit;
+  if(mat.transmission.factor > 0.0f)
+    return HitGroup_Transmission;
+  return HitGroup_Opaque;
+}
+
 void AccelStructure::createTopLevelAS(nvh::GltfScene& gltfScene)
 {
   std::vector<VkAccelerationStructureInstanceKHR> tlas;
   tlas.reserve(gltfScene.m_nodes.size());
+  std::array<int, HitGroupCount> nbPerGroup{};
 
   for(auto& node : gltfScene.m_nodes)
   {
@@ -107,9 +125,11 @@ void AccelStructure::createTopLevelAS(nvh::GltfScene& gltfScene)
     nvh::GltfPrimMesh&         primMesh = gltfScene.m_primMeshes[node.primMesh];
     nvh::GltfMaterial&         mat      = gltfScene.m_materials[primMesh.materialIndex];
 
-    // Always opaque, no need to use anyhit (faster)
-    if(mat.alphaMode == 0 || (mat.baseColorFactor.w == 1.0f && mat.baseColorTexture == -1))
+    // Only the alpha tested materials go through the any hit shader
+    int hitGroup = materialHitGroup(mat);
+    if(hitGroup != HitGroup_AlphaMask)
       flags |= VK_GEOMETRY_INSTANCE_FORCE_OPAQUE_BIT_KHR;
+    nbPerGroup[hitGroup]++;
     // Need to skip the cull flag in traceray_rtx for double sided materials
     if(mat.doubleSided == 1)
       flags |= VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
@@ -119,11 +139,12 @@ void AccelStructure::createTopLevelAS(nvh::GltfScene& gltfScene)
     rayInst.instanceCustomIndex            = node.primMesh;  // gl_InstanceCustomIndexEXT: to find which primitive
     rayInst.accelerationStructureReference = m_rtBuilder.getBlasDeviceAddress(node.primMesh);
     rayInst.flags                          = flags;
-    rayInst.instanceShaderBindingTableRecordOffset = 0;  // We will use the same hit group for all objects
+    rayInst.instanceShaderBindingTableRecordOffset = hitGroup;  // Hit group of the material class
     rayInst.mask                                   = 0xFF;
     tlas.emplace_back(rayInst);
   }
-  LOGI(" TLAS(%zu)", tlas.size());
+  LOGI(" TLAS(%zu: %d opaque, %d alpha mask, %d transmission, %d unlit)", tlas.size(), nbPerGroup[HitGroup_Opaque],
+       nbPerGroup[HitGroup_AlphaMask], nbPerGroup[HitGroup_Transmission], nbPerGroup[HitGroup_Unlit]);
   m_rtBuilder.buildTlas(tlas, VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR);
 }
 
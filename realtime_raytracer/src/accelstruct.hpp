@@ -21,6 +21,8 @@ public:
   VkDescriptorSetLayout      getDescLayout() { return m_rtDescSetLayout; }
   VkDescriptorSet            getDescSet() { return m_rtDescSet; }
 
+  static int materialHitGroup(const nvh::GltfMaterial& mat);
+
 private:
   nvvk::RaytracingBuilderKHR::BlasInput primitiveToGeometry(const nvh::GltfPrimMesh& prim, VkBuffer vertex, VkBuffer index);
   void                                  createBottomLevelAS(nvh::GltfScene& gltfScene, const std::vector<nvvk::Buffer>& vertex, const std::vector<nvvk::Buffer>& index);
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Submission of the path tracing on the compute queue, at its own rate, synchronized with the
+ *  display on the graphics queue through timeline semaphores.
+ */
+
+
+#include <array>
+#include <vector>
+
+#include "async_compute.hpp"
+#include "gpu_profiler.hpp"
+#include "tools.hpp"
+
+
+void AsyncCompute::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, const nvvk::Queue& queue)
+{
+  m_device = device;
+  m_queue  = queue;
+  m_debug.setup(device);
+
+  // Timing the traces, if the queue supports timestamps
+  uint32_t count{0};
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+  std::vector<VkQueueFamilyProperties> families(count);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+  if(queue.familyIndex < count && families[queue.familyIndex].timestampValidBits > 0)
+  {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+  }
+
+  VkQueryPoolCreateInfo queryInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+  queryInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+  queryInfo.queryCount = 4;
+  vkCreateQueryPool(m_device, &queryInfo, nullptr, &m_queryPool);
+  NAME_VK(m_queryPool);
+
+  VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+  poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  poolInfo.queueFamilyIndex = queue.familyIndex;
+  vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_cmdPool);
+
+  // A single command buffer: it is only recorded again once its trace is done
+  VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+  allocInfo.commandPool        = m_cmdPool;
+  allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = 1;
+  vkAllocateCommandBuffers(m_device, &allocInfo, &m_cmdBuf);
+
+  // Both counters start at 0, no trace
+  VkSemaphoreTypeCreateInfo timelineInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+  timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timelineInfo.initialValue  = 0;
+  VkSemaphoreCreateInfo semaphoreInfo{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  semaphoreInfo.pNext = &timelineInfo;
+  vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_traced);
+  vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_resolvedSemaphore);
+  NAME_VK(m_traced);
+  NAME_VK(m_resolvedSemaphore);
+}
+
+void AsyncCompute::destroy()
+{
+  vkDestroySemaphore(m_device, m_traced, nullptr);
+  vkDestroySemaphore(m_device, m_resolvedSemaphore, nullptr);
+  vkDestroyCommandPool(m_device, m_cmdPool, nullptr);
+  vkDestroyQueryPool(m_device, m_queryPool, nullptr);
+
+  m_traced            = VK_NULL_HANDLE;
+  m_resolvedSemaphore = VK_NULL_HANDLE;
+  m_cmdPool           = VK_NULL_HANDLE;
+  m_cmdBuf            = VK_NULL_HANDLE;
+  m_queryPool         = VK_NULL_HANDLE;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Start of a display frame: returns true if the last trace is done and was not displayed yet.
+// This display frame must then resolve it, which also allows the next trace.
+//
+bool AsyncCompute::acquireResult()
+{
+  m_hasResolve = false;
+  if(m_resolved == m_frame)
+    return false;  // Still displaying the last one, nothing new
+
+  uint64_t traced{0};
+  vkGetSemaphoreCounterValue(m_device, m_traced, &traced);
+  if(traced < m_frame)
+    return false;  // Still tracing
+
+  m_resolved   = m_frame;
+  m_hasResolve = true;
+
+  // The trace is done, its timestamps are available
+  std::array<uint64_t, 2> ticks{};
+  if(m_timestampPeriod > 0.f
+     && vkGetQueryPoolResults(m_device, m_queryPool, 0, 2, sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT)
+            == VK_SUCCESS)
+    m_traceTime = float(double(ticks[1] - ticks[0]) * m_timestampPeriod * 1e-6);
+  m_tilesTime = 0.f;
+  if(m_tilesTimed
+     && vkGetQueryPoolResults(m_device, m_queryPool, 2, 2, sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT)
+            == VK_SUCCESS)
+    m_tilesTime = float(double(ticks[1] - ticks[0]) * m_timestampPeriod * 1e-6);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The previous trace is done (canTrace), its command buffer can be recorded again
+//
+VkCommandBuffer AsyncCompute::beginTrace()
+{
+  assert(canTrace());
+  m_frame++;
+
+  VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkResetCommandBuffer(m_cmdBuf, 0);
+  vkBeginCommandBuffer(m_cmdBuf, &beginInfo);
+  GpuProfiler::get().beginFrame(m_cmdBuf, m_queue.familyIndex);
+
+  m_tilesTimed = false;
+  if(m_timestampPeriod > 0.f)
+  {
+    vkCmdResetQueryPool(m_cmdBuf, m_queryPool, 0, 4);
+    vkCmdWriteTimestamp(m_cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+  }
+  return m_cmdBuf;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Timing the tiles of the trace being recorded: the start waits for the work recorded before
+// them (selection, reprojection), which is then not counted
+//
+void AsyncCompute::beginTiles()
+{
+  if(m_timestampPeriod > 0.f)
+    vkCmdWriteTimestamp(m_cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2);
+}
+
+void AsyncCompute::endTiles()
+{
+  if(m_timestampPeriod > 0.f)
+  {
+    vkCmdWriteTimestamp(m_cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 3);
+    m_tilesTimed = true;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// The trace writes the result image: it waits for the copy of the previous trace, which the
+// graphics submission of this display frame signals (wait-before-signal of timeline semaphores)
+//
+void AsyncCompute::submitTrace()
+{
+  if(m_timestampPeriod > 0.f)
+    vkCmdWriteTimestamp(m_cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 1);
+  vkEndCommandBuffer(m_cmdBuf);
+
+  const uint64_t             waitValue   = m_frame - 1;
+  const uint64_t             signalValue = m_frame;
+  const VkPipelineStageFlags waitStage   = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.waitSemaphoreValueCount   = 1;
+  timelineInfo.pWaitSemaphoreValues      = &waitValue;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues    = &signalValue;
+
+  VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.pNext                = &timelineInfo;
+  submitInfo.waitSemaphoreCount   = 1;
+  submitInfo.pWaitSemaphores      = &m_resolvedSemaphore;
+  submitInfo.pWaitDstStageMask    = &waitStage;
+  submitInfo.commandBufferCount   = 1;
+  submitInfo.pCommandBuffers      = &m_cmdBuf;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores    = &m_traced;
+
+  vkQueueSubmit(m_queue.queue, 1, &submitInfo, VK_NULL_HANDLE);
+}
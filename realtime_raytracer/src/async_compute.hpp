@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include "nvvk/debug_util_vk.hpp"
+#include "queue.hpp"
+
+
+/*
+
+Progressive path tracing on the compute queue, decoupled from the display
+* The display loop runs at the refresh rate of the swapchain and never waits for the trace: each
+  display frame shows the latest completed trace. A trace takes as many display frames as it
+  needs, which keeps the UI responsive and the presentation latency low while a heavy scene
+  converges.
+* One trace is in flight at a time. It writes the result image (S_OUT), which the graphics queue
+  copies to the displayed image once the trace is done (resolve). The next trace is submitted in
+  the same display frame and waits for that copy on the GPU.
+* Two timeline semaphores, counting the traces:
+  - traced:   signaled with t by the compute queue when trace t is done
+  - resolved: signaled with t by the graphics queue when trace t is copied to the display
+  The host only polls them, it never blocks.
+* The GPU time of each trace is measured with timestamps, read once it is done (getTraceTime).
+  The tiles of a tiled trace are timed on their own (getTilesTime), without the work around them.
+
+* Usage, for each display frame
+  - acquireResult: a completed trace to resolve in this display frame
+  - canTrace: if so, beginTrace, record the ray tracing, submitTrace
+  - beginTiles and endTiles around the tiles, if the trace is tiled
+  - submit the graphics command buffer with the semaphores, if hasResolve
+*/
+class AsyncCompute
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, const nvvk::Queue& queue);
+  void destroy();
+
+  // Graphics queue
+  bool acquireResult();
+  bool hasResolve() const { return m_hasResolve; }
+
+  // Compute queue
+  bool            canTrace() const { return m_resolved == m_frame; }
+  VkCommandBuffer beginTrace();
+  void            beginTiles();
+  void            endTiles();
+  void            submitTrace();
+
+  // Semaphores of the graphics submission resolving trace getResolveValue
+  VkSemaphore getTraced() const { return m_traced; }
+  VkSemaphore getResolved() const { return m_resolvedSemaphore; }
+  uint64_t    getResolveValue() const { return m_resolved; }
+  uint64_t    getTraceValue() const { return m_frame; }  // Trace being recorded, after beginTrace
+
+  float getTraceTime() const { return m_traceTime; }  // GPU time of the last completed trace (ms), 0 if unknown
+  float getTilesTime() const { return m_tilesTime; }  // Of its tiles only (ms), 0 if unknown or not tiled
+
+private:
+  uint64_t m_frame{0};     // Last trace submitted
+  uint64_t m_resolved{0};  // Last trace copied to the display, or being copied in this frame
+  bool     m_hasResolve{false};
+  float    m_traceTime{0.f};
+  float    m_tilesTime{0.f};
+  bool     m_tilesTimed{false};  // The trace being recorded, or the last one, has its tiles timed
+
+  VkSemaphore     m_traced{VK_NULL_HANDLE};
+  VkSemaphore     m_resolvedSemaphore{VK_NULL_HANDLE};
+  VkCommandPool   m_cmdPool{VK_NULL_HANDLE};
+  VkCommandBuffer m_cmdBuf{VK_NULL_HANDLE};
+  VkQueryPool     m_queryPool{VK_NULL_HANDLE};  // Timestamps at the start and end of the trace, then of the tiles
+  float           m_timestampPeriod{0.f};       // Nanoseconds per tick, 0 without timestamps
+
+  // Setup
+  nvvk::DebugUtil m_debug;  // Utility to name objects
+  VkDevice        m_device{VK_NULL_HANDLE};
+  nvvk::Queue     m_queue;
+};
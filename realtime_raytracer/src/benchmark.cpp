@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Benchmark driver: rendering a matrix of scenes and settings headless, and reporting the
+ *  timings in JSON and CSV
+ */
+
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "benchmark.hpp"
+#include "headless.hpp"
+#include "nvh/fileoperations.hpp"
+#include "raytracer.hpp"
+#include "tools.hpp"
+
+extern std::vector<std::string> defaultSearchPaths;
+
+
+//--------------------------------------------------------------------------------------------------
+// Key and values, one per line
+//
+bool Benchmark::loadMatrix(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    LOGE("Cannot open the benchmark matrix: %s\n", filename.c_str());
+    return false;
+  }
+
+  auto readInts = [](std::istringstream& iss, std::vector<int>& values) {
+    values.clear();
+    int v;
+    while(iss >> v)
+      values.push_back(v);
+    return !values.empty();
+  };
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    std::istringstream iss(line);
+    std::string        key;
+    if(!(iss >> key) || key[0] == '#')
+      continue;
+
+    std::string value;
+    bool        ok = true;
+    if(key == "scene" && (iss >> value))
+      m_scenes.push_back(value);
+    else if(key == "hdr" && (iss >> value))
+      m_hdrs.push_back(value);
+    else if(key == "foveation")
+      ok = readInts(iss, m_foveation);
+    else if(key == "samples")
+      ok = readInts(iss, m_samples);
+    else if(key == "depth")
+      ok = readInts(iss, m_depths);
+    else if(key == "frames")
+      ok = static_cast<bool>(iss >> m_frames);
+    else if(key == "warmup")
+      ok = static_cast<bool>(iss >> m_warmup);
+    else if(key == "camera" && (iss >> m_cameraPath))
+      iss >> m_cameraSeed;
+    else
+      ok = false;
+    if(!ok)
+      LOGW("Benchmark: ignoring line '%s'\n", line.c_str());
+  }
+
+  if(m_scenes.empty() || m_hdrs.empty() || m_frames <= 0)
+  {
+    LOGE("Benchmark: %s needs at least a scene, an hdr and frames > 0\n", filename.c_str());
+    return false;
+  }
+  m_warmup = std::max(m_warmup, 0);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Scenes and environments are only loaded when they change, the settings vary the fastest
+//
+int Benchmark::run(const std::string& matrixFile, int rndMethod, const std::string& output)
+{
+  if(!loadMatrix(matrixFile))
+    return 1;
+
+  if(!m_cameraPath.empty())
+  {
+    std::string cameraFile = nvh::findFile(m_cameraPath, defaultSearchPaths, true);
+    if(cameraFile.empty() || !_se->m_cameraPath.load(cameraFile))
+    {
+      LOGE("Benchmark: camera path %s not available\n", m_cameraPath.c_str());
+      return 1;
+    }
+    _se->m_cameraPath.m_loop = true;
+  }
+
+  bool        created = false;
+  std::string loadedHdr;
+  float       hdrLoadMs{0}, sceneLoadMs{0}, pipelineMs{0};
+  for(const auto& scene : m_scenes)
+  {
+    std::string sceneFile = nvh::findFile(scene, defaultSearchPaths, true);
+    if(sceneFile.empty())
+    {
+      LOGE("Benchmark: scene %s not found\n", scene.c_str());
+      return 1;
+    }
+    bool sceneLoaded = false;
+
+    for(const auto& hdr : m_hdrs)
+    {
+      MilliTimer timer;
+      if(hdr != loadedHdr)
+      {
+        std::string hdrFile = nvh::findFile(hdr, defaultSearchPaths, true);
+        if(hdrFile.empty())
+        {
+          LOGE("Benchmark: environment %s not found\n", hdr.c_str());
+          return 1;
+        }
+        _se->loadEnvironmentHdr(hdrFile);
+        if(created)
+          _se->updateHdrDescriptors();
+        hdrLoadMs = static_cast<float>(timer.elapsed());
+        loadedHdr = hdr;
+      }
+
+      if(!sceneLoaded)
+      {
+        timer.reset();
+        _se->loadScene(sceneFile);
+        sceneLoadMs = static_cast<float>(timer.elapsed());
+
+        timer.reset();
+        if(!created)
+        {
+          _se->createUniformBuffer();
+          _se->createDescriptorSetLayout();
+          _se->createRender(static_cast<Raytracer::RndMethod>(rndMethod));
+          created = true;
+        }
+        else
+        {
+          _se->recreateRender();
+        }
+        pipelineMs  = static_cast<float>(timer.elapsed());
+        sceneLoaded = true;
+      }
+
+      for(int foveation : m_foveation)
+        for(int samples : m_samples)
+          for(int depth : m_depths)
+          {
+            Cell cell;
+            cell.scene       = scene;
+            cell.hdr         = hdr;
+            cell.foveation   = foveation;
+            cell.samples     = samples;
+            cell.depth       = depth;
+            cell.sceneLoadMs = sceneLoadMs;
+            cell.hdrLoadMs   = hdrLoadMs;
+            cell.pipelineMs  = pipelineMs;
+            measure(cell);
+            LOGI("Benchmark: %s, %s, foveation %d, %d spp, depth %d: %.3f ms (p99 %.3f)\n", scene.c_str(), hdr.c_str(),
+                 foveation, samples, depth, cell.gpuMs.avg, cell.gpuMs.p99);
+            m_cells.push_back(cell);
+          }
+    }
+  }
+
+  bool ok = writeJson(output + ".json");
+  ok &= writeCsv(output + ".csv");
+  return ok ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Rendering the cell from a reset, and from the start of the camera path if any. Each headless
+// frame resolves the trace of the previous one: its GPU time is measured then, with the number
+// of samples it traced.
+//
+void Benchmark::measure(Cell& cell)
+{
+  RtxState& state       = _se->m_rtxState;
+  state.enableFoveation = cell.foveation;
+  state.maxSamples      = cell.samples;
+  state.maxDepth        = cell.depth;
+  _se->m_maxFrames      = m_warmup + m_frames + 2;  // Never done
+  _se->resetFrame();
+  if(!m_cameraPath.empty())
+    _se->m_cameraPath.play(m_cameraSeed);
+
+  const VkExtent2D&  size = _se->m_size;
+  std::vector<float> gpu, wall;
+  double             samples{0}, gpuTotal{0}, peak{-1};
+  double             rays{0}, pixels{0}, candidates{0};
+  uint32_t           countedTraces = _se->m_rayStats.getTraces();
+  for(int i = 0; i <= m_warmup + m_frames; i++)
+  {
+    MilliTimer timer;
+    bool       resolved = m_headless->frame(false);
+    float      frameMs  = static_cast<float>(timer.elapsed());
+
+    // The first frame resolves the last trace of the previous cell
+    if(i > m_warmup && resolved)
+    {
+      gpu.push_back(_se->m_asyncCompute.getTraceTime());
+      wall.push_back(frameMs);
+      gpuTotal += gpu.back();
+
+      // Pixels of the resolved trace: its selection is read back with its timeline value
+      uint64_t trace  = _se->m_asyncCompute.getResolveValue();
+      double   traced = cell.foveation == 1 ? _se->m_pixelSelect.getSelectedPixels(trace) : double(size.width) * size.height;
+      samples += traced * cell.samples;
+
+      // Counters of the same trace, read back when it was resolved if it did work
+      if(_se->m_rayStats.getTraces() != countedTraces)
+      {
+        const RayCounters& counters = _se->m_rayStats.getLast();
+        rays += double(_se->m_rayStats.getLastRays());
+        pixels += counters.pixels;
+        candidates += counters.candidates;
+      }
+    }
+
+    peak          = std::max(peak, getMemoryUsage());
+    countedTraces = _se->m_rayStats.getTraces();
+  }
+
+  _se->m_cameraPath.stop();
+
+  cell.frames           = static_cast<int>(gpu.size());
+  cell.gpuMs            = percentiles(gpu);
+  cell.frameMs          = percentiles(wall);
+  cell.samplesPerSecond = gpuTotal > 0 ? samples / (gpuTotal * 1e-3) : 0;
+  cell.raysPerSecond    = gpuTotal > 0 ? rays / (gpuTotal * 1e-3) : 0;
+  cell.skipRatio        = candidates > 0 ? float(1.0 - std::min(pixels / candidates, 1.0)) : 0.f;
+  cell.peakMemoryMB     = peak;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Device local memory in use by the process, in MB
+//
+double Benchmark::getMemoryUsage() const
+{
+  if(!m_memoryBudget)
+    return -1;
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+  VkPhysicalDeviceMemoryProperties2         properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2, &budget};
+  vkGetPhysicalDeviceMemoryProperties2(_se->m_physicalDevice, &properties);
+
+  double usage{0};
+  for(uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; i++)
+    if(properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+      usage += double(budget.heapUsage[i]);
+  return usage / (1024.0 * 1024.0);
+}
+
+Benchmark::Percentiles Benchmark::percentiles(std::vector<float> values)
+{
+  Percentiles p;
+  if(values.empty())
+    return p;
+
+  std::sort(values.begin(), values.end());
+  auto at = [&](size_t percent) { return values[std::min(values.size() - 1, values.size() * percent / 100)]; };
+  for(float v : values)
+    p.avg += v;
+  p.avg /= static_cast<float>(values.size());
+  p.p50 = at(50);
+  p.p90 = at(90);
+  p.p99 = at(99);
+  return p;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reports
+//
+static std::string quoted(const std::string& s)
+{
+  std::string q = "\"";
+  for(char c : s)
+  {
+    if(c == '"' || c == '\\')
+      q += '\\';
+    q += c;
+  }
+  return q + "\"";
+}
+
+bool Benchmark::writeJson(const std::string& filename) const
+{
+  std::ofstream file(filename, std::ios::trunc);
+  if(!file.is_open())
+  {
+    LOGE("Benchmark: cannot write %s\n", filename.c_str());
+    return false;
+  }
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(_se->m_physicalDevice, &properties);
+  const char* renderers[] = {"RtxPipeline", "RayQuery", "Wavefront"};
+
+  auto writePercentiles = [&](const char* name, const Percentiles& p) {
+    file << "      " << quoted(name) << ": {\"avg\": " << p.avg << ", \"p50\": " << p.p50 << ", \"p90\": " << p.p90
+         << ", \"p99\": " << p.p99 << "},\n";
+  };
+
+  file << "{\n";
+  file << "  \"device\": " << quoted(properties.deviceName) << ",\n";
+  file << "  \"renderer\": " << quoted(_se->m_rndMethod < Raytracer::eNone ? renderers[_se->m_rndMethod] : "None") << ",\n";
+  file << "  \"width\": " << _se->m_size.width << ",\n";
+  file << "  \"height\": " << _se->m_size.height << ",\n";
+  file << "  \"frames\": " << m_frames << ",\n";
+  file << "  \"warmup\": " << m_warmup << ",\n";
+  file << "  \"cameraPath\": " << quoted(m_cameraPath) << ",\n";
+  file << "  \"cameraSeed\": " << m_cameraSeed << ",\n";
+  file << "  \"cells\": [\n";
+  for(size_t i = 0; i < m_cells.size(); i++)
+  {
+    const Cell& c = m_cells[i];
+    file << "    {\n";
+    file << "      \"scene\": " << quoted(c.scene) << ",\n";
+    file << "      \"hdr\": " << quoted(c.hdr) << ",\n";
+    file << "      \"foveation\": " << c.foveation << ",\n";
+    file << "      \"samples\": " << c.samples << ",\n";
+    file << "      \"depth\": " << c.depth << ",\n";
+    file << "      \"loadMs\": {\"scene\": " << c.sceneLoadMs << ", \"hdr\": " << c.hdrLoadMs << ", \"pipelines\": " << c.pipelineMs << "},\n";
+    file << "      \"frames\": " << c.frames << ",\n";
+    writePercentiles("gpuMs", c.gpuMs);
+    writePercentiles("frameMs", c.frameMs);
+    file << "      \"samplesPerSecond\": " << c.samplesPerSecond << ",\n";
+    file << "      \"raysPerSecond\": " << c.raysPerSecond << ",\n";
+    file << "      \"skipRatio\": " << c.skipRatio << ",\n";
+    file << "      \"peakMemoryMB\": " << c.peakMemoryMB << "\n";
+    file << "    }" << (i + 1 < m_cells.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+  LOGI("Benchmark: wrote %s\n", filename.c_str());
+  return true;
+}
+
+bool Benchmark::writeCsv(const std::string& filename) const
+{
+  std::ofstream file(filename, std::ios::trunc);
+  if(!file.is_open())
+  {
+    LOGE("Benchmark: cannot write %s\n", filename.c_str());
+    return false;
+  }
+
+  file << "scene,hdr,foveation,samples,depth,sceneLoadMs,hdrLoadMs,pipelineMs,frames,gpuAvgMs,gpuP50Ms,gpuP90Ms,gpuP99Ms,"
+          "frameAvgMs,frameP50Ms,frameP90Ms,frameP99Ms,samplesPerSecond,raysPerSecond,skipRatio,peakMemoryMB\n";
+  for(const Cell& c : m_cells)
+  {
+    file << quoted(c.scene) << ',' << quoted(c.hdr) << ',' << c.foveation << ',' << c.samples << ',' << c.depth << ','
+         << c.sceneLoadMs << ',' << c.hdrLoadMs << ',' << c.pipelineMs << ',' << c.frames << ',' << c.gpuMs.avg << ','
+         << c.gpuMs.p50 << ',' << c.gpuMs.p90 << ',' << c.gpuMs.p99 << ',' << c.frameMs.avg << ',' << c.frameMs.p50 << ','
+         << c.frameMs.p90 << ',' << c.frameMs.p99 << ',' << c.samplesPerSecond << ',' << c.raysPerSecond << ','
+         << c.skipRatio << ',' << c.peakMemoryMB << '\n';
+  }
+  LOGI("Benchmark: wrote %s\n", filename.c_str());
+  return true;
+}
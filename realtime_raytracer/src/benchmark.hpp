@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+
+class Raytracer;
+class Headless;
+
+/*
+
+Benchmark: a matrix of scenes x environments x settings, rendered headless
+* Matrix file, one key per line, the settings lists are combined:
+    # comment
+    scene <gltf>          (one line per scene)
+    hdr <hdr>             (one line per environment)
+    foveation <0|1> ...   (RtxState::enableFoveation)
+    samples <n> ...       (RtxState::maxSamples)
+    depth <n> ...         (RtxState::maxDepth)
+    frames <n>            (measured traces per cell, default 64)
+    warmup <n>            (traces before measuring, default 8)
+    camera <path> [seed]  (camera path replayed in loop by every cell, from its start)
+* Each scene and environment is loaded once, with the time of the loading phases: scene and
+  acceleration structures, environment and its importance sampling, pipelines.
+* Per cell: GPU time of the traces and wall time of the frames (average and percentiles),
+  samples and rays per second, skipped pixels and peak device memory (VK_EXT_memory_budget, -1 without it).
+* Report: <output>.json and <output>.csv, one entry per cell.
+
+* Usage
+  - after Headless::setup, with the renderer to use, instead of loading the scene
+  - run: returns the exit status
+*/
+class Benchmark
+{
+public:
+  Benchmark(Raytracer* _s, Headless* headless, bool memoryBudget)
+      : _se(_s)
+      , m_headless(headless)
+      , m_memoryBudget(memoryBudget)
+  {
+  }
+  int run(const std::string& matrixFile, int rndMethod, const std::string& output);
+
+private:
+  struct Percentiles
+  {
+    float avg{0};
+    float p50{0};
+    float p90{0};
+    float p99{0};
+  };
+  struct Cell
+  {
+    std::string scene;
+    std::string hdr;
+    int         foveation{0};
+    int         samples{1};
+    int         depth{10};
+    // Loading phases of the scene and environment of the cell, in ms
+    float       sceneLoadMs{0};
+    float       hdrLoadMs{0};
+    float       pipelineMs{0};
+    // Measures
+    int         frames{0};
+    Percentiles gpuMs;
+    Percentiles frameMs;
+    double      samplesPerSecond{0};
+    double      raysPerSecond{0};  // RayCounters, 0 when not counted
+    float       skipRatio{0};      // Pixels considered and not traced, over all traces
+    double      peakMemoryMB{-1};
+  };
+
+  bool               loadMatrix(const std::string& filename);
+  void               measure(Cell& cell);
+  double             getMemoryUsage() const;
+  static Percentiles percentiles(std::vector<float> values);
+  bool               writeJson(const std::string& filename) const;
+  bool               writeCsv(const std::string& filename) const;
+
+  Raytracer* _se{nullptr};
+  Headless*  m_headless{nullptr};
+  bool       m_memoryBudget{false};
+
+  // Matrix
+  std::vector<std::string> m_scenes;
+  std::vector<std::string> m_hdrs;
+  std::vector<int>         m_foveation{0};
+  std::vector<int>         m_samples{1};
+  std::vector<int>         m_depths{10};
+  int                      m_frames{64};
+  int                      m_warmup{8};
+  std::string              m_cameraPath;
+  uint32_t                 m_cameraSeed{1};
+
+  std::vector<Cell> m_cells;
+};
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Camera path: recording and frame locked playback of the camera and gaze
+ */
+
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "camera_path.hpp"
+#include "nvh/cameramanipulator.hpp"
+
+
+//--------------------------------------------------------------------------------------------------
+// Recording
+//
+void CameraPath::startRecording()
+{
+  m_frames.clear();
+  m_next  = 0;
+  m_state = eRecording;
+  m_clock.reset();
+  LOGI("Camera path: recording\n");
+}
+
+void CameraPath::recordFrame(const nvmath::vec2f& gaze)
+{
+  if(m_state != eRecording)
+    return;
+
+  CameraPathFrame frame;
+  frame.time = m_clock.elapsed() / 1000.0;
+  CameraManip.getLookat(frame.eye, frame.center, frame.up);
+  frame.fov  = CameraManip.getFov();
+  frame.gaze = gaze;
+  m_frames.push_back(frame);
+}
+
+bool CameraPath::stopRecording(const std::string& filename)
+{
+  if(m_state != eRecording)
+    return false;
+  m_state = eIdle;
+
+  std::ofstream file(filename, std::ios::trunc);
+  if(!file.is_open())
+  {
+    LOGE("Camera path: cannot write %s\n", filename.c_str());
+    return false;
+  }
+
+  file << "# time eye(3) center(3) up(3) fov gaze(2)\n";
+  file << std::setprecision(9);
+  for(const auto& f : m_frames)
+  {
+    file << f.time << ' ' << f.eye.x << ' ' << f.eye.y << ' ' << f.eye.z << ' ' << f.center.x << ' ' << f.center.y << ' '
+         << f.center.z << ' ' << f.up.x << ' ' << f.up.y << ' ' << f.up.z << ' ' << f.fov << ' ' << f.gaze.x << ' '
+         << f.gaze.y << '\n';
+  }
+  LOGI("Camera path: %zu frames written to %s\n", m_frames.size(), filename.c_str());
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Playback
+//
+bool CameraPath::load(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    LOGE("Cannot open camera path: %s\n", filename.c_str());
+    return false;
+  }
+
+  m_state = eIdle;
+  m_frames.clear();
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::istringstream iss(line);
+    CameraPathFrame    f;
+    if(iss >> f.time >> f.eye.x >> f.eye.y >> f.eye.z >> f.center.x >> f.center.y >> f.center.z >> f.up.x >> f.up.y
+       >> f.up.z >> f.fov >> f.gaze.x >> f.gaze.y)
+      m_frames.push_back(f);
+  }
+
+  LOGI("Camera path: %zu frames from %s\n", m_frames.size(), filename.c_str());
+  m_filename = filename;
+  m_next     = 0;
+  return !m_frames.empty();
+}
+
+bool CameraPath::play(uint32_t seed)
+{
+  if(m_frames.empty() || m_state == eRecording)
+    return false;
+  m_seed  = seed;
+  m_next  = 0;
+  m_state = ePlaying;
+  return true;
+}
+
+void CameraPath::stop()
+{
+  if(m_state == ePlaying)
+    m_state = eIdle;
+}
+
+// Integer hash (Wang), the seed of a frame only depends on the playback seed and the frame index
+static uint32_t hashSeed(uint32_t seed)
+{
+  seed = (seed ^ 61u) ^ (seed >> 16u);
+  seed *= 9u;
+  seed = seed ^ (seed >> 4u);
+  seed *= 0x27d4eb2du;
+  seed = seed ^ (seed >> 15u);
+  return seed;
+}
+
+bool CameraPath::playFrame(nvmath::vec2f& gaze, uint32_t& frameSeed)
+{
+  if(m_state != ePlaying)
+    return false;
+
+  if(m_next >= m_frames.size())
+  {
+    if(!m_loop)
+    {
+      m_state = eIdle;
+      LOGI("Camera path: playback done\n");
+      return false;
+    }
+    m_next = 0;
+  }
+
+  const CameraPathFrame& f = m_frames[m_next];
+  CameraManip.setCamera({f.eye, f.center, f.up, f.fov}, true);
+  gaze      = f.gaze;
+  frameSeed = hashSeed(m_seed * 0x9e3779b9u + static_cast<uint32_t>(m_next));
+  m_next++;
+  return true;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "nvmath/nvmath.h"
+#include "tools.hpp"
+
+
+/*
+
+Camera path: recording the camera and gaze of each frame, and replaying them
+* Text file, one frame per line, lines starting with '#' are ignored:
+    time  eye.x eye.y eye.z  center.x center.y center.z  up.x up.y up.z  fov  gaze.x gaze.y
+  time in seconds since the start of the recording, fov in degrees, gaze normalized.
+* The playback is frame locked: one recorded frame per rendered frame, whatever the time it
+  takes, so two runs see the same cameras in the same order. Each frame also gets a random
+  seed fixed by the seed of the playback and the frame index (RtxState::frameSeed).
+* The timestamps are informative: the controllers driven by time (dynamic resolution,
+  foveation budget, tiled trace) are not replayed and should be off for identical runs.
+
+* Usage
+  - startRecording, then stopRecording writes the file
+  - load a file, then play, optionally looping
+  - at each frame start: playFrame sets the camera of the frame, recordFrame adds it
+*/
+
+struct CameraPathFrame
+{
+  double        time{0};
+  nvmath::vec3f eye{0, 0, 1};
+  nvmath::vec3f center{0, 0, 0};
+  nvmath::vec3f up{0, 1, 0};
+  float         fov{60.f};
+  nvmath::vec2f gaze{0.5f, 0.5f};
+};
+
+class CameraPath
+{
+public:
+  enum State
+  {
+    eIdle,
+    eRecording,
+    ePlaying,
+  };
+
+  void startRecording();
+  bool stopRecording(const std::string& filename);
+  bool load(const std::string& filename);
+  bool play(uint32_t seed);
+  void stop();
+
+  // Playback: setting the camera of the frame with its gaze and seed, false if not playing
+  bool playFrame(nvmath::vec2f& gaze, uint32_t& frameSeed);
+  // Recording: adding the current camera with the gaze used for the frame
+  void recordFrame(const nvmath::vec2f& gaze);
+
+  State    getState() const { return m_state; }
+  bool     isPlaying() const { return m_state == ePlaying; }
+  size_t   getFrameCount() const { return m_frames.size(); }
+  size_t   getPosition() const { return m_next; }
+  uint32_t getSeed() const { return m_seed; }
+
+  bool        m_loop{false};  // Restarting the playback at the end of the path
+  std::string m_filename{"camera_path.txt"};
+
+private:
+  State                        m_state{eIdle};
+  std::vector<CameraPathFrame> m_frames;
+  size_t                       m_next{0};
+  uint32_t                     m_seed{1};
+  MilliTimer                   m_clock;
+};
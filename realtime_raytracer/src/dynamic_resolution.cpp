@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Controller of the trace resolution from the measured GPU time.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "dynamic_resolution.hpp"
+
+
+static const int   kHoldTraces = 4;      // Traces out of the band before changing
+static const float kScaleStep  = 1.f / 32.f;  // Scales are multiples of this, no change for less
+
+
+//--------------------------------------------------------------------------------------------------
+// Moving the scale toward the target once the average left the band, from the ratio of the
+// times: the cost is proportional to the number of pixels.
+//
+bool DynamicResolution::update(float traceMs, float targetMs)
+{
+  if(!m_enable || traceMs <= 0.f)
+    return false;
+
+  m_average = m_average > 0.f ? m_average * 0.8f + traceMs * 0.2f : traceMs;
+
+  if(m_average > targetMs * (1.f + m_band))
+    m_outside = std::max(m_outside, 0) + 1;
+  else if(m_average < targetMs * (1.f - m_band))
+    m_outside = std::min(m_outside, 0) - 1;
+  else
+    m_outside = 0;
+
+  if(std::abs(m_outside) < kHoldTraces)
+    return false;
+
+  // Scale of the target time, at most doubling or halving the cost at once
+  float ratio = std::clamp(targetMs / m_average, 0.5f, 2.f);
+  float scale = m_scale * std::sqrt(ratio);
+  scale       = std::round(std::clamp(scale, m_minScale, 1.f) / kScaleStep) * kScaleStep;
+  m_outside   = 0;
+  if(scale == m_scale)
+    return false;
+
+  m_scale   = scale;
+  m_average = 0.f;  // Measured again at the new resolution
+  return true;
+}
+
+VkExtent2D DynamicResolution::getExtent(const VkExtent2D& region) const
+{
+  float scale = getScale();
+  return {std::max(1u, static_cast<uint32_t>(float(region.width) * scale)),
+          std::max(1u, static_cast<uint32_t>(float(region.height) * scale))};
+}
+
+void DynamicResolution::reset()
+{
+  m_scale   = 1.f;
+  m_average = 0.f;
+  m_outside = 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+
+/*
+
+Dynamic resolution: closed loop on the GPU time of the trace
+* The trace covers a scaled extent of the render region, the display stretches it over the
+  region (post.frag). The scale applies to both axes, the cost goes with its square.
+* The measured time is averaged over the traces. Hysteresis: the scale only changes after the
+  average stayed out of the band around the target for a number of traces in a row, and by
+  steps. A change restarts the accumulation, which is at the old resolution.
+
+* Usage
+  - update, with the GPU time of each completed trace which did work and the target, m_targetMs
+    unless another controller owns the time. Returns true if the scale changed.
+  - getExtent: the extent to trace for a region
+*/
+class DynamicResolution
+{
+public:
+  bool       update(float traceMs, float targetMs);
+  VkExtent2D getExtent(const VkExtent2D& region) const;
+  float      getScale() const { return m_enable ? m_scale : 1.f; }
+  float      getAverage() const { return m_average; }
+  void       reset();
+
+  bool  m_enable{false};
+  float m_targetMs{16.6f};  // GPU time of a trace
+  float m_minScale{0.25f};
+  float m_band{0.1f};  // Relative to the target, no change inside
+
+private:
+  float m_scale{1.f};
+  float m_average{0.f};  // ms, 0 until measured
+  int   m_outside{0};    // Traces in a row above (>0) or below (<0) the band
+};
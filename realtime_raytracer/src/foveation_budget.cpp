@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Controller of the foveation profile from the measured GPU time of the trace
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "foveation_budget.hpp"
+#include "nvh/nvprint.hpp"
+
+
+static const float kLevelStep = 1.f / 32.f;  // Published level, the LUT is rebuilt at each step
+static const float kDeadBand  = 0.05f;       // Relative error without correction
+
+
+//--------------------------------------------------------------------------------------------------
+// Integrating the relative error of the average time: the level settles where the budget is met
+//
+bool FoveationBudget::update(float traceMs)
+{
+  if(!m_enable || traceMs <= 0.f)
+    return false;
+
+  m_average = m_average > 0.f ? m_average * 0.8f + traceMs * 0.2f : traceMs;
+  m_traces++;
+
+  float error = (m_average - m_budgetMs) / m_budgetMs;
+  if(std::abs(error) > kDeadBand)
+    m_level = std::clamp(m_level + m_gain * std::clamp(error, -1.f, 1.f), 0.f, 1.f);
+
+  m_history[m_historyOffset] = m_average;
+  m_historyOffset            = (m_historyOffset + 1) % static_cast<int>(m_history.size());
+
+  float published = std::round(m_level / kLevelStep) * kLevelStep;
+  bool  changed   = published != m_published;
+  m_published     = published;
+
+  writeTelemetry(traceMs);
+  return changed;
+}
+
+void FoveationBudget::reset()
+{
+  m_level     = 0.f;
+  m_published = 0.f;
+  m_average   = 0.f;
+}
+
+//--------------------------------------------------------------------------------------------------
+// CSV, one line per measured trace
+//
+bool FoveationBudget::openTelemetry(const std::string& filename)
+{
+  m_telemetry.open(filename, std::ios::trunc);
+  if(!m_telemetry.is_open())
+  {
+    LOGE("Cannot open the foveation telemetry: %s\n", filename.c_str());
+    return false;
+  }
+  m_telemetry << "trace,timeMs,averageMs,budgetMs,level,radiusScale,intervalScale\n";
+  return true;
+}
+
+void FoveationBudget::writeTelemetry(float traceMs)
+{
+  if(!m_telemetry.is_open())
+    return;
+  m_telemetry << m_traces << ',' << traceMs << ',' << m_average << ',' << m_budgetMs << ',' << m_published << ','
+              << getRadiusScale() << ',' << getIntervalScale() << '\n';
+}
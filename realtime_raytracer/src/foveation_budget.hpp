@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/*
+
+Foveation budget: closed loop on the GPU time of the trace, adjusting the foveation profile
+* A level in [0, 1] drives the adjustment of the active profile: 0 is the profile as authored,
+  1 shrinks the eccentricities of the rings by minRadiusScale and multiplies the frame intervals
+  of the periphery by maxIntervalScale. The fovea never gets smaller than minFoveaDeg.
+* At each measured trace, the level moves in proportion to the relative error of the averaged
+  time to the budget. It is published by steps, each step rebuilds the LUT of the profile.
+  The accumulation is kept: the foveation only changes where the next samples go.
+* Telemetry: the state after each trace, in a ring buffer for the GUI and, if opened, in a CSV
+  file (trace, time, average, level, radius scale, interval scale).
+
+* Usage
+  - update, with the GPU time of each completed frame which did work (a pass of tiles for the
+    tiled trace), while the foveation owns the time (see Raytracer::preparePost). Returns true if the
+    adjustment changed: apply getRadiusScale, getIntervalScale and m_minFoveaDeg to the profile.
+*/
+class FoveationBudget
+{
+public:
+  bool update(float traceMs);
+  void reset();
+  bool openTelemetry(const std::string& filename);
+
+  float getLevel() const { return m_published; }
+  float getAverage() const { return m_average; }
+  float getRadiusScale() const { return 1.f - m_published * (1.f - m_minRadiusScale); }
+  float getIntervalScale() const { return 1.f + m_published * (m_maxIntervalScale - 1.f); }
+
+  const std::vector<float>& getHistory() const { return m_history; }  // Averaged times, cycling
+  int                       getHistoryOffset() const { return m_historyOffset; }
+
+  bool  m_enable{false};
+  float m_budgetMs{12.f};        // GPU time of a trace
+  float m_minFoveaDeg{3.f};      // Radius always traced as in the fovea, in degrees
+  float m_minRadiusScale{0.25f};
+  float m_maxIntervalScale{3.f};
+  float m_gain{0.2f};            // Level change for a relative error of 1
+
+private:
+  void writeTelemetry(float traceMs);
+
+  float    m_level{0.f};
+  float    m_published{0.f};  // Level of the profile, by steps
+  float    m_average{0.f};    // ms, 0 until measured
+  uint64_t m_traces{0};
+
+  std::vector<float> m_history = std::vector<float>(128, 0.f);
+  int                m_historyOffset{0};
+  std::ofstream      m_telemetry;
+};
@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+/*
+ *  Foveation profiles: loading the tables and resampling the active one for the shaders
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "foveation_profile.hpp"
+#include "nvh/nvprint.hpp"
+
+
+//--------------------------------------------------------------------------------------------------
+// Built-in profile, used when no table file is found. Close to the former screen-space rings
+// (0.05, 0.15, 0.3 of the width) seen with the default 60 degrees vertical field of view.
+//
+FoveationProfiles::FoveationProfiles()
+{
+  m_profiles.push_back({"Default", {{0.f, 1.f, 1}, {6.f, 0.9f, 2}, {17.f, 0.72f, 3}, {32.f, 0.49f, 4}, {60.f, 0.05f, 4}}});
+  m_profiles.push_back({"Default Simplified",
+                        {{0.f, 1.f, 1},
+                         {6.f, 0.9f, 2, 6, 0.9f, FoveaPath_NoDetail},
+                         {17.f, 0.72f, 3, 4, 0.75f, FoveaPath_NoDetail | FoveaPath_SimpleBsdf},
+                         {32.f, 0.49f, 4, 2, 0.5f, FoveaPath_NoDetail | FoveaPath_SimpleBsdf},
+                         {60.f, 0.05f, 4, 2, 0.5f, FoveaPath_NoDetail | FoveaPath_SimpleBsdf}}});
+  buildLut();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Replacing the profiles by the ones of the table file
+//
+bool FoveationProfiles::load(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    LOGE("Cannot open foveation profiles: %s\n", filename.c_str());
+    return false;
+  }
+
+  std::vector<Profile> profiles;
+  std::string          line;
+  while(std::getline(file, line))
+  {
+    std::istringstream iss(line);
+    std::string        first;
+    if(!(iss >> first) || first[0] == '#')
+      continue;
+
+    if(first == "profile")
+    {
+      Profile profile;
+      std::getline(iss >> std::ws, profile.name);
+      profiles.push_back(profile);
+      continue;
+    }
+
+    Row row;
+    if(profiles.empty() || !parseRow(line, row))
+    {
+      LOGW("Foveation profiles: ignoring line '%s'\n", line.c_str());
+      continue;
+    }
+    profiles.back().rows.push_back(row);
+  }
+
+  // Rows in increasing eccentricity, profiles without rows are dropped
+  for(auto& p : profiles)
+    std::stable_sort(p.rows.begin(), p.rows.end(), [](const Row& a, const Row& b) { return a.eccentricity < b.eccentricity; });
+  profiles.erase(std::remove_if(profiles.begin(), profiles.end(), [](const Profile& p) { return p.rows.empty(); }),
+                 profiles.end());
+
+  if(profiles.empty())
+  {
+    LOGE("No foveation profile in %s\n", filename.c_str());
+    return false;
+  }
+
+  LOGI("Foveation profiles: %zu from %s\n", profiles.size(), filename.c_str());
+  m_profiles = std::move(profiles);
+  m_active   = 0;
+  buildLut();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// <eccentricity> <probability> <frameInterval> [<maxDepth> [<rrFactor> [simple] [nodetail]]]
+//
+bool FoveationProfiles::parseRow(const std::string& line, Row& row)
+{
+  std::istringstream iss(line);
+  if(!(iss >> row.eccentricity >> row.probability >> row.frameInterval))
+    return false;
+
+  // Optional columns, a failed extraction would zero the value
+  int   maxDepth;
+  float rrFactor;
+  if(iss >> maxDepth)
+  {
+    row.maxDepth = maxDepth;
+    if(iss >> rrFactor)
+    {
+      row.rrFactor = rrFactor;
+      std::string flag;
+      while(iss >> flag)
+      {
+        if(flag == "simple")
+          row.pathFlags |= FoveaPath_SimpleBsdf;
+        else if(flag == "nodetail")
+          row.pathFlags |= FoveaPath_NoDetail;
+        else
+          return false;
+      }
+    }
+  }
+
+  row.probability   = std::min(std::max(row.probability, 0.f), 1.f);
+  row.frameInterval = std::max(row.frameInterval, 1);
+  row.maxDepth      = std::max(row.maxDepth, 0);
+  row.rrFactor      = std::min(std::max(row.rrFactor, 0.05f), 1.f);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+//
+//
+bool FoveationProfiles::select(int index)
+{
+  if(index < 0 || index >= static_cast<int>(m_profiles.size()))
+    return false;
+  m_active = index;
+  buildLut();
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The rings of the active profile move toward the gaze (radiusScale < 1) and their pixels are
+// traced less often (intervalScale > 1). Within minFovea, the first row applies.
+//
+void FoveationProfiles::adjust(float radiusScale, float intervalScale, float minFovea)
+{
+  m_radiusScale   = std::max(radiusScale, 0.01f);
+  m_intervalScale = std::max(intervalScale, 1.f);
+  m_minFovea      = minFovea;
+  buildLut();
+}
+
+std::vector<std::string> FoveationProfiles::getNames() const
+{
+  std::vector<std::string> names;
+  for(const auto& p : m_profiles)
+    names.push_back(p.name);
+  return names;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Resampling the active profile at regular eccentricities, up to its last row
+//
+void FoveationProfiles::buildLut()
+{
+  const auto& rows = m_profiles[m_active].rows;
+  m_range          = std::max(rows.back().eccentricity, 1.f);
+
+  for(int i = 0; i < FoveaLutSize; i++)
+  {
+    float ecc = m_range * static_cast<float>(i) / static_cast<float>(FoveaLutSize - 1);
+    ecc       = ecc < m_minFovea ? 0.f : ecc / m_radiusScale;  // Adjustment, the profile at this eccentricity
+
+    // First row beyond the eccentricity
+    auto next = std::upper_bound(rows.begin(), rows.end(), ecc, [](float e, const Row& r) { return e < r.eccentricity; });
+    auto  prev        = next == rows.begin() ? next : next - 1;
+    float probability = prev->probability;
+    if(next != rows.begin() && next != rows.end())
+    {
+      float t     = (ecc - prev->eccentricity) / std::max(next->eccentricity - prev->eccentricity, 1e-6f);
+      probability = prev->probability + t * (next->probability - prev->probability);
+    }
+    int interval = prev->frameInterval;
+    if(interval > 1)
+      interval = static_cast<int>(std::round(static_cast<float>(interval) * m_intervalScale));
+    m_lut[i] = {probability, interval, prev->maxDepth, prev->rrFactor, prev->pathFlags};
+  }
+  m_dirty = true;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Foveation profiles, defined in degrees of visual angle
+* A profile is a table of rows: eccentricity (degrees from the gaze direction), probability for
+  a pixel to be traced and number of frames between two traces. Optionally, the path policy of
+  the ring: maximum depth (0: no limit), factor on the russian roulette continuation and the
+  simplifications `simple` (Lambert + GGX) and `nodetail` (no normal/clearcoat maps, anisotropy).
+  Probabilities are interpolated between rows, everything else is the one of the row at or below
+  the eccentricity. Beyond the last row, the last row applies.
+* Table file, one profile per `profile` line, followed by its rows:
+    # comment
+    profile <name>
+    <eccentricity> <probability> <frameInterval> [<maxDepth> [<rrFactor> [simple] [nodetail]]]
+* The active profile is resampled into FoveaLutSize entries (FoveaLutEntry), uploaded to the
+  eFoveaLut buffer and indexed by eccentricity in shaders/foveation.glsl.
+
+* The profile can be adjusted at runtime (FoveationBudget): eccentricities scaled, except within a
+  minimum fovea, and the frame intervals of the rings multiplied.
+
+* Usage
+  - load a table file, or keep the built-in default
+  - select a profile, optionally adjust it, then upload getLut when isDirty
+*/
+class FoveationProfiles
+{
+public:
+  struct Row
+  {
+    float eccentricity{0};
+    float probability{1};
+    int   frameInterval{1};
+    int   maxDepth{0};
+    float rrFactor{1};
+    int   pathFlags{0};  // FoveaPath_xxx
+  };
+
+  struct Profile
+  {
+    std::string      name;
+    std::vector<Row> rows;
+  };
+
+  FoveationProfiles();
+
+  bool load(const std::string& filename);
+  bool select(int index);
+  void adjust(float radiusScale, float intervalScale, float minFovea);
+
+  int                      getActive() const { return m_active; }
+  std::vector<std::string> getNames() const;
+  float                    getRange() const { return m_range; }  // Eccentricity covered by the LUT
+
+  const std::array<FoveaLutEntry, FoveaLutSize>& getLut() const { return m_lut; }
+  bool                                           isDirty() const { return m_dirty; }
+  void                                           clearDirty() { m_dirty = false; }
+
+private:
+  bool parseRow(const std::string& line, Row& row);
+  void buildLut();
+
+  std::vector<Profile>                    m_profiles;
+  int                                     m_active{0};
+  std::array<FoveaLutEntry, FoveaLutSize> m_lut{};
+  float                                   m_range{1.f};
+  bool                                    m_dirty{true};
+
+  // Adjustment of the active profile
+  float m_radiusScale{1.f};
+  float m_intervalScale{1.f};
+  float m_minFovea{0.f};  // Degrees
+};
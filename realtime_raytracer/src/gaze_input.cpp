@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Gaze sources: mouse, recorded trace and local socket feed of an eye tracker
+ */
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "gaze_input.hpp"
+
+
+//--------------------------------------------------------------------------------------------------
+// Mouse
+//
+void MouseGazeSource::setCursor(const nvmath::vec2f& pos)
+{
+  m_cursor = pos;
+  m_moved  = true;
+}
+
+bool MouseGazeSource::poll(GazeSample& sample)
+{
+  if(!m_moved)
+    return false;
+  sample.position = m_cursor;
+  m_moved         = false;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Recorded trace
+//
+bool FileGazeSource::load(const std::string& filename)
+{
+  std::ifstream file(filename);
+  if(!file.is_open())
+  {
+    LOGE("Cannot open gaze trace: %s\n", filename.c_str());
+    return false;
+  }
+
+  m_samples.clear();
+  std::string line;
+  while(std::getline(file, line))
+  {
+    if(line.empty() || line[0] == '#')
+      continue;
+    std::istringstream iss(line);
+    GazeSample         sample;
+    if(iss >> sample.time >> sample.position.x >> sample.position.y)
+      m_samples.push_back(sample);
+  }
+
+  LOGI("Gaze trace: %zu samples from %s\n", m_samples.size(), filename.c_str());
+  m_next = 0;
+  m_clock.reset();
+  return !m_samples.empty();
+}
+
+// Returning the most recent sample which time has been reached
+bool FileGazeSource::poll(GazeSample& sample)
+{
+  double now      = m_clock.elapsed() / 1000.0;
+  bool   newValue = false;
+  while(m_next < m_samples.size() && m_samples[m_next].time <= now)
+  {
+    sample   = m_samples[m_next++];
+    newValue = true;
+  }
+  return newValue;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Socket
+//
+#ifdef _WIN32
+using socket_t = SOCKET;
+static void closeSocket(socket_t s)
+{
+  closesocket(s);
+}
+static bool isValidSocket(socket_t s)
+{
+  return s != INVALID_SOCKET;
+}
+#else
+using socket_t = int;
+static void closeSocket(socket_t s)
+{
+  close(s);
+}
+static bool isValidSocket(socket_t s)
+{
+  return s >= 0;
+}
+#endif
+
+SocketGazeSource::~SocketGazeSource()
+{
+  if(m_socket != -1)
+    closeSocket(static_cast<socket_t>(m_socket));
+#ifndef _WIN32
+  if(!m_unixPath.empty())
+    unlink(m_unixPath.c_str());
+#endif
+}
+
+bool SocketGazeSource::open(const std::string& address)
+{
+  socket_t s = static_cast<socket_t>(-1);
+
+  if(address.rfind("udp:", 0) == 0)
+  {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+    const char* portText = address.c_str() + 4;
+    char*       end      = nullptr;
+    long        port     = strtol(portText, &end, 10);
+    if(end == portText || *end != '\0' || port <= 0 || port > 65535)
+    {
+      LOGW("Gaze socket: invalid UDP port in %s\n", address.c_str());
+      return false;
+    }
+    s = socket(AF_INET, SOCK_DGRAM, 0);
+    if(!isValidSocket(s))
+    {
+      LOGE("Gaze socket: cannot create the UDP socket\n");
+      return false;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+      LOGE("Gaze socket: cannot bind UDP port %ld\n", port);
+      closeSocket(s);
+      return false;
+    }
+  }
+#ifndef _WIN32
+  else if(address.rfind("unix:", 0) == 0)
+  {
+    s = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(!isValidSocket(s))
+    {
+      LOGE("Gaze socket: cannot create the Unix socket\n");
+      return false;
+    }
+    m_unixPath = address.substr(5);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, m_unixPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(m_unixPath.c_str());
+    if(bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+      LOGE("Gaze socket: cannot bind %s\n", m_unixPath.c_str());
+      closeSocket(s);
+      m_unixPath.clear();
+      return false;
+    }
+  }
+#endif
+  else
+  {
+    LOGE("Gaze socket: unknown address %s\n", address.c_str());
+    return false;
+  }
+
+  // Never blocking the render loop
+#ifdef _WIN32
+  u_long nonBlocking = 1;
+  ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+  m_socket = static_cast<intptr_t>(s);
+  m_clock.reset();
+  LOGI("Gaze socket listening on %s\n", address.c_str());
+  return true;
+}
+
+// Text "x y", whatever the length of the datagram
+bool SocketGazeSource::parse(const char* data, size_t size, nvmath::vec2f& pos)
+{
+  std::istringstream iss(std::string(data, size));
+  return static_cast<bool>(iss >> pos.x >> pos.y);
+}
+
+// Draining all pending datagrams, only the last one matters
+bool SocketGazeSource::poll(GazeSample& sample)
+{
+  if(m_socket == -1)
+    return false;
+
+  bool newValue = false;
+  char buffer[256];
+  while(true)
+  {
+    auto received = recv(static_cast<socket_t>(m_socket), buffer, sizeof(buffer), 0);
+    if(received <= 0)
+      break;
+
+    nvmath::vec2f pos;
+    if(parse(buffer, static_cast<size_t>(received), pos))
+    {
+      sample.time     = m_clock.elapsed() / 1000.0;
+      sample.position = pos;
+      newValue        = true;
+    }
+  }
+  return newValue;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Creating the source from its description
+//
+bool GazeInput::create(const std::string& description)
+{
+  std::unique_ptr<GazeSource> source;
+  SourceType                  type;
+
+  if(description == "center")
+  {
+    source = std::make_unique<CenterGazeSource>();
+    type   = eCenter;
+  }
+  else if(description == "mouse")
+  {
+    source = std::make_unique<MouseGazeSource>();
+    type   = eMouse;
+  }
+  else if(description.rfind("file:", 0) == 0)
+  {
+    auto file = std::make_unique<FileGazeSource>();
+    if(!file->load(description.substr(5)))
+      return false;
+    source = std::move(file);
+    type   = eFile;
+  }
+  else
+  {
+    auto sock = std::make_unique<SocketGazeSource>();
+    if(!sock->open(description))
+      return false;
+    source = std::move(sock);
+    type   = eSocket;
+  }
+
+  m_source             = std::move(source);
+  m_type               = type;
+  m_descriptions[type] = description;
+  m_sample             = {};  // Back to the center until the first sample
+  return true;
+}
+
+bool GazeInput::setType(SourceType type)
+{
+  if(type == m_type)
+    return true;
+  if(m_descriptions[type].empty())
+    return false;
+  return create(m_descriptions[type]);
+}
+
+void GazeInput::update()
+{
+  GazeSample sample;
+  if(m_source && m_source->poll(sample))
+  {
+    m_sample            = sample;
+    m_sample.position.x = std::min(std::max(sample.position.x, 0.f), 1.f);
+    m_sample.position.y = std::min(std::max(sample.position.y, 0.f), 1.f);
+  }
+}
+
+void GazeInput::setCursor(const nvmath::vec2f& pos)
+{
+  if(m_type == eMouse)
+    static_cast<MouseGazeSource*>(m_source.get())->setCursor(pos);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "nvmath/nvmath.h"
+#include "tools.hpp"
+
+
+/*
+
+Gaze input driving the center of the fovea
+* A GazeSource delivers gaze samples, in normalized coordinates [0..1] of the rendering region
+  (0,0 top-left). Available sources:
+  - center : fixed at the center of the screen
+  - mouse  : the cursor position, set by the window callbacks
+  - file   : a recorded gaze trace, replayed in real time
+  - socket : datagrams from a local eye tracker (or a program standing for it)
+
+* Usage
+  - create from a description string, or setType to switch back to a previously created source
+  - update at each frame, then read getPosition
+*/
+
+struct GazeSample
+{
+  double        time{0};              // Seconds, relative to the start of the source
+  nvmath::vec2f position{0.5f, 0.5f};  // Normalized, in the rendering region
+};
+
+class GazeSource
+{
+public:
+  virtual ~GazeSource() = default;
+  // Return true if a new sample was available
+  virtual bool              poll(GazeSample& sample) = 0;
+  virtual const std::string name()                  = 0;
+};
+
+//--------------------------------------------------------------------------------------------------
+// Fixed at the center of the screen, this is the behavior without eye tracking
+//
+class CenterGazeSource : public GazeSource
+{
+public:
+  bool              poll(GazeSample& sample) override { return false; }
+  const std::string name() override { return "Center"; }
+};
+
+//--------------------------------------------------------------------------------------------------
+// Following the mouse cursor
+//
+class MouseGazeSource : public GazeSource
+{
+public:
+  bool              poll(GazeSample& sample) override;
+  const std::string name() override { return "Mouse"; }
+  void              setCursor(const nvmath::vec2f& pos);
+
+private:
+  nvmath::vec2f m_cursor{0.5f, 0.5f};
+  bool          m_moved{false};
+};
+
+//--------------------------------------------------------------------------------------------------
+// Replaying a recorded trace. Text file, one sample per line: `time x y`
+// time in seconds, x and y normalized. Lines starting with '#' are ignored.
+//
+class FileGazeSource : public GazeSource
+{
+public:
+  bool              load(const std::string& filename);
+  bool              poll(GazeSample& sample) override;
+  const std::string name() override { return "Trace File"; }
+
+private:
+  std::vector<GazeSample> m_samples;
+  size_t                  m_next{0};
+  MilliTimer              m_clock;
+};
+
+//--------------------------------------------------------------------------------------------------
+// Local socket feed: each datagram holds a sample as text `x y`, other datagrams are ignored.
+// - "udp:<port>"  : UDP on the loopback interface
+// - "unix:<path>" : Unix datagram socket (not on Windows)
+//
+class SocketGazeSource : public GazeSource
+{
+public:
+  ~SocketGazeSource() override;
+  bool              open(const std::string& address);
+  bool              poll(GazeSample& sample) override;
+  const std::string name() override { return "Socket"; }
+
+private:
+  bool parse(const char* data, size_t size, nvmath::vec2f& pos);
+
+  intptr_t    m_socket{-1};
+  std::string m_unixPath;
+  MilliTimer  m_clock;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// Holds the active source and the last gaze position
+//
+class GazeInput
+{
+public:
+  enum SourceType
+  {
+    eCenter,
+    eMouse,
+    eFile,
+    eSocket,
+  };
+
+  // "center", "mouse", "file:<path>", "udp:<port>" or "unix:<path>"
+  bool       create(const std::string& description);
+  bool       setType(SourceType type);
+  void       update();
+  void       setCursor(const nvmath::vec2f& pos);
+  SourceType getType() const { return m_type; }
+
+  const nvmath::vec2f& getPosition() const { return m_sample.position; }
+  const std::string    getSourceName() { return m_source ? m_source->name() : "None"; }
+
+private:
+  std::unique_ptr<GazeSource> m_source{std::make_unique<CenterGazeSource>()};
+  SourceType                  m_type{eCenter};
+  GazeSample                  m_sample;
+
+  // Last description used for each type of source
+  std::array<std::string, 4> m_descriptions{"center", "mouse", "", "udp:5005"};
+};
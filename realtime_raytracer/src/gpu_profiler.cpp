@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  GPU timings of the labelled scopes with timestamp queries, read back without waiting
+ */
+
+
+#include <algorithm>
+
+#include "gpu_profiler.hpp"
+#include "nvh/nvprint.hpp"
+
+
+GpuProfiler& GpuProfiler::get()
+{
+  static GpuProfiler profiler;
+  return profiler;
+}
+
+void GpuProfiler::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice)
+{
+  m_device = device;
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  m_timestampPeriod = properties.limits.timestampPeriod;
+
+  uint32_t count{0};
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+  std::vector<VkQueueFamilyProperties> families(count);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+  for(const auto& f : families)
+    m_familyTimestamps.push_back(f.timestampValidBits > 0);
+}
+
+void GpuProfiler::destroy()
+{
+  for(auto& f : m_frames)
+    vkDestroyQueryPool(m_device, f.second.queryPool, nullptr);
+  m_frames.clear();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The command buffer is being recorded again, so its previous submission is done
+//
+void GpuProfiler::beginFrame(VkCommandBuffer cmdBuf, uint32_t familyIndex)
+{
+  if(m_device == VK_NULL_HANDLE || familyIndex >= m_familyTimestamps.size() || !m_familyTimestamps[familyIndex])
+    return;
+
+  Frame& frame = m_frames[cmdBuf];
+  readFrame(frame);
+
+  // Room for all the scopes of the previous recording, the pool is no longer in use
+  if(frame.queryPool == VK_NULL_HANDLE || (frame.dropped > 0 && frame.capacity < kMaxQueries))
+  {
+    uint32_t capacity = frame.capacity == 0 ? kInitialQueries : std::max(frame.capacity * 2, frame.capacity + frame.dropped * 2);
+    frame.capacity    = std::min(capacity, kMaxQueries);
+    vkDestroyQueryPool(m_device, frame.queryPool, nullptr);
+
+    VkQueryPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    poolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = frame.capacity;
+    vkCreateQueryPool(m_device, &poolInfo, nullptr, &frame.queryPool);
+  }
+  frame.dropped = 0;
+
+  vkCmdResetQueryPool(cmdBuf, frame.queryPool, 0, frame.capacity);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Sums of the scopes of each section, added to the history
+//
+void GpuProfiler::readFrame(Frame& frame)
+{
+  if(frame.nbQueries == 0)
+    return;
+
+  std::vector<uint64_t> ticks(frame.nbQueries);
+  VkResult result = vkGetQueryPoolResults(m_device, frame.queryPool, 0, frame.nbQueries, frame.nbQueries * sizeof(uint64_t),
+                                          ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+  if(result == VK_SUCCESS)
+  {
+    std::vector<float> sums(m_sections.size(), -1.f);
+    for(const auto& t : frame.timings)
+    {
+      float ms       = float(double(ticks[t.query + 1] - ticks[t.query]) * m_timestampPeriod * 1e-6);
+      sums[t.section] = std::max(sums[t.section], 0.f) + ms;
+    }
+
+    m_submission++;
+    for(size_t i = 0; i < sums.size(); i++)
+    {
+      if(sums[i] < 0.f)
+        continue;
+      Section& s          = m_sections[i];
+      s.history[s.offset] = sums[i];
+      s.offset            = (s.offset + 1) % kSectionHistory;
+      s.count             = std::min(s.count + 1, kSectionHistory);
+      if(m_csv.is_open())
+        m_csv << m_submission << ',' << s.name << ',' << sums[i] << '\n';
+    }
+  }
+
+  frame.nbQueries = 0;
+  frame.timings.clear();
+}
+
+int GpuProfiler::getSection(const std::string& name)
+{
+  auto it = m_sectionIndex.find(name);
+  if(it != m_sectionIndex.end())
+    return it->second;
+
+  Section s;
+  s.name = name;
+  s.history.resize(kSectionHistory);
+  m_sections.push_back(s);
+  m_sectionIndex[name] = static_cast<int>(m_sections.size()) - 1;
+  return m_sectionIndex[name];
+}
+
+//--------------------------------------------------------------------------------------------------
+// Min, average and 99th percentile over the history of each section, in order of appearance
+//
+std::vector<GpuProfiler::Stats> GpuProfiler::getStats() const
+{
+  std::vector<Stats> stats;
+  for(const auto& s : m_sections)
+  {
+    if(s.count == 0)
+      continue;
+    std::vector<float> values(s.history.begin(), s.history.begin() + s.count);
+    std::sort(values.begin(), values.end());
+
+    Stats st;
+    st.name  = s.name;
+    st.minMs = values.front();
+    for(float v : values)
+      st.avgMs += v;
+    st.avgMs /= static_cast<float>(values.size());
+    st.p99Ms = values[std::min(values.size() - 1, (values.size() * 99) / 100)];
+    stats.push_back(st);
+  }
+  return stats;
+}
+
+bool GpuProfiler::openCsv(const std::string& filename)
+{
+  m_csv.open(filename, std::ios::trunc);
+  if(!m_csv.is_open())
+  {
+    LOGE("Cannot open the profiler CSV: %s\n", filename.c_str());
+    return false;
+  }
+  m_csv << "submission,section,ms\n";
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// "path/render_output.cpp" and "genMipmap" give "render_output::genMipmap"
+//
+std::string GpuProfiler::sectionName(const char* file, const char* function)
+{
+  std::string name(file);
+  size_t      slash = name.find_last_of("/\\");
+  if(slash != std::string::npos)
+    name = name.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  if(dot != std::string::npos)
+    name = name.substr(0, dot);
+  return name + "::" + function;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Scope: two queries of the command buffer, if it takes part and has room for them
+//
+GpuProfiler::Scope::Scope(GpuProfiler& profiler, VkCommandBuffer cmdBuf, const std::string& name)
+    : m_profiler(profiler)
+    , m_cmdBuf(cmdBuf)
+{
+  auto it = profiler.m_frames.find(cmdBuf);
+  if(it == profiler.m_frames.end())
+    return;
+
+  Frame& frame = it->second;
+  if(frame.nbQueries + 2 > frame.capacity)
+  {
+    frame.dropped++;
+    if(!profiler.m_droppedReported)
+      LOGW("GPU profiler: more than %u timestamps in a command buffer, '%s' not timed until the pool grows\n",
+           frame.capacity, name.c_str());
+    profiler.m_droppedReported = true;
+    return;
+  }
+
+  m_section    = profiler.getSection(name);
+  m_query      = frame.nbQueries;
+  frame.nbQueries += 2;
+  frame.timings.push_back({m_section, m_query});
+  vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, m_query);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+  if(m_section < 0)
+    return;
+  vkCmdWriteTimestamp(m_cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_profiler.m_frames[m_cmdBuf].queryPool, m_query + 1);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+
+/*
+
+GPU profiler, timestamps around the labelled scopes
+* Each command buffer taking part (beginFrame) has its own query pool. Its timestamps are read
+  when it is recorded again: it is then no longer pending, so they are all available and the
+  host never waits. This covers both the display frames and the trace on the compute queue.
+* A section is named after the file and function of the scope ("render_output::genMipmap"). The
+  scopes of a section in one command buffer are summed (e.g. the tiles of the trace), and the
+  last SectionHistory sums are kept to report min, average and 99th percentile.
+* Optional CSV stream: one line per section and command buffer (submission, section, ms).
+* Scopes in command buffers which did not beginFrame are ignored, as on queues without
+  timestamps. The pool of a command buffer grows at its next beginFrame when scopes did not fit
+  (e.g. many tiles in a trace), up to kMaxQueries; the first dropped scope is reported.
+
+* Usage
+  - setup, then beginFrame right after vkBeginCommandBuffer
+  - PROFILE_SCOPE_VK(cmdBuf) next to LABEL_SCOPE_VK, or scope(cmdBuf, name) for a given name
+  - getStats for the report
+*/
+class GpuProfiler
+{
+public:
+  struct Stats
+  {
+    std::string name;
+    float       minMs{0};
+    float       avgMs{0};
+    float       p99Ms{0};
+  };
+
+  // Timestamps written at construction and destruction
+  class Scope
+  {
+  public:
+    Scope(GpuProfiler& profiler, VkCommandBuffer cmdBuf, const std::string& name);
+    Scope(const Scope&) = delete;
+    ~Scope();
+
+  private:
+    GpuProfiler&    m_profiler;
+    VkCommandBuffer m_cmdBuf;
+    int             m_section{-1};
+    uint32_t        m_query{0};
+  };
+
+  static GpuProfiler& get();  // The scopes of all classes go to the same profiler
+
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice);
+  void destroy();
+
+  void  beginFrame(VkCommandBuffer cmdBuf, uint32_t familyIndex);
+  Scope scope(VkCommandBuffer cmdBuf, const std::string& name) { return Scope(*this, cmdBuf, name); }
+
+  std::vector<Stats> getStats() const;
+  bool               openCsv(const std::string& filename);
+
+  static std::string sectionName(const char* file, const char* function);
+
+private:
+  static constexpr uint32_t kInitialQueries = 128;   // Per command buffer, two per scope
+  static constexpr uint32_t kMaxQueries     = 4096;  // Growing up to
+  static constexpr uint32_t kSectionHistory = 256;
+
+  struct Timing
+  {
+    int      section;
+    uint32_t query;  // Start, the end is the next one
+  };
+  struct Frame
+  {
+    VkQueryPool         queryPool{VK_NULL_HANDLE};
+    uint32_t            capacity{0};
+    uint32_t            nbQueries{0};
+    uint32_t            dropped{0};  // Scopes without room in the pool, which grows for the next recording
+    std::vector<Timing> timings;
+  };
+  struct Section
+  {
+    std::string        name;
+    std::vector<float> history;  // Cycling, the last `count` ones are valid
+    uint32_t           offset{0};
+    uint32_t           count{0};
+  };
+
+  int  getSection(const std::string& name);
+  void readFrame(Frame& frame);
+
+  std::unordered_map<VkCommandBuffer, Frame> m_frames;
+  std::vector<Section>                       m_sections;
+  std::unordered_map<std::string, int>       m_sectionIndex;
+  std::vector<bool>                          m_familyTimestamps;
+  std::ofstream                              m_csv;
+  uint64_t                                   m_submission{0};
+  bool                                       m_droppedReported{false};
+
+  VkDevice m_device{VK_NULL_HANDLE};
+  float    m_timestampPeriod{1.f};  // Nanoseconds per tick
+};
+
+// Timing the enclosing scope, named as the file and function
+#define PROFILE_SCOPE_VK(_cmdBuf)                                                                                      \
+  auto _profileScope = GpuProfiler::get().scope(_cmdBuf, GpuProfiler::sectionName(__FILE__, __FUNCTION__))
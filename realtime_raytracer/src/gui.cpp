@@ -10,6 +10,7 @@
 #include "rtx_pipeline.hpp"
 #include "raytracer.hpp"
 #include "gui.hpp"
+#include "gpu_profiler.hpp"
 #include "tools.hpp"
 
 #include "nvml_monitor.hpp"
@@ -32,13 +33,21 @@ void GUI::render()
     bool changed{false};
 
     if(ImGui::CollapsingHeader("Camera"), ImGuiTreeNodeFlags_DefaultOpen)
+    {
       changed |= ImGuiH::CameraWidget();
+      guiCameraPath();
+    }
     if(ImGui::CollapsingHeader("Ray Tracing" ), ImGuiTreeNodeFlags_DefaultOpen)
       changed |= guiRayTracing();
     if(ImGui::CollapsingHeader("Post-Processing" ), ImGuiTreeNodeFlags_DefaultOpen)
       changed |= guiTonemapper();
     if(ImGui::CollapsingHeader("Environment" ))
       changed |= guiEnvironment();
+    if(ImGui::CollapsingHeader("Profiler"))
+    {
+      guiProfiler();
+      changed |= guiHeatmap();
+    }
 
     if(ImGui::Button("Load Scene"))
     {
@@ -71,6 +80,41 @@ void GUI::render()
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// Recording and playback of the camera path, in the file of the command line (-cameraRecord or
+// -cameraPlay). A stopped recording can be replayed right away.
+//
+void GUI::guiCameraPath()
+{
+  CameraPath& path = _se->m_cameraPath;
+  GuiH::Group<bool>("Path", true, [&] {
+    GuiH::Info("File", "", path.m_filename, GuiH::Flags::Disabled);
+    switch(path.getState())
+    {
+      case CameraPath::eIdle:
+        GuiH::Checkbox("Loop", "Restart the playback at the end of the path", &path.m_loop, nullptr);
+        if(ImGui::Button("Record"))
+          path.startRecording();
+        ImGui::SameLine();
+        if(ImGui::Button("Play") && (path.getFrameCount() > 0 || path.load(path.m_filename)))
+          path.play(path.getSeed());
+        break;
+      case CameraPath::eRecording:
+        GuiH::Info("Recorded", "", std::to_string(path.getFrameCount()) + " frames", GuiH::Flags::Disabled);
+        if(ImGui::Button("Stop"))
+          path.stopRecording(path.m_filename);
+        break;
+      case CameraPath::ePlaying:
+        GuiH::Info("Frame", "", std::to_string(path.getPosition()) + " / " + std::to_string(path.getFrameCount()),
+                   GuiH::Flags::Disabled);
+        if(ImGui::Button("Stop"))
+          path.stop();
+        break;
+    }
+    return false;
+  });
+}
+
 bool GUI::guiRayTracing()
 {
   auto  Normal = ImGuiH::Control::Flags::Normal;
@@ -79,16 +123,148 @@ bool GUI::guiRayTracing()
 
   changed |= GuiH::Checkbox("Enable Foveation", "", (bool*)&rtxState.enableFoveation, nullptr);
   changed |= GuiH::Checkbox("Periphery Blur", "", (bool*)&rtxState.enablePeripheryBlur, nullptr);
+  if(rtxState.enableFoveation)
+  {
+    // Moving the fovea only changes where the next samples go, no need to restart the accumulation
+    GuiH::Group<bool>("Fovea", true, [&] {
+      int gazeType = _se->m_gaze.getType();
+      if(GuiH::Selection("Gaze Input", "Source driving the center of the fovea", &gazeType, nullptr, Normal,
+                         {"Center", "Mouse", "Trace File", "Socket"}))
+        _se->m_gaze.setType(static_cast<GazeInput::SourceType>(gazeType));
+      int profile = _se->m_foveation.getActive();
+      if(GuiH::Selection("Profile", "Probability and frame interval by eccentricity, in degrees of visual angle",
+                         &profile, nullptr, Normal, _se->m_foveation.getNames()))
+        _se->m_foveation.select(profile);
+      // The visual angle of the pixels changes, so does the sampling
+      if(_se->m_displayPixelPitchMm > 0.f)
+        changed |= GuiH::Slider("View Distance", "Distance from the eye to the display, in millimeters",
+                                &_se->m_viewDistanceMm, nullptr, Normal, 200.f, 2000.f);
+      else
+        GuiH::Info("View Distance", "No -displayPitch, visual angle through the camera", "-", GuiH::Flags::Disabled);
+      GuiH::Info("Profile Range", "Eccentricity covered by the profile", std::to_string(rtxState.foveaLutRange) + " deg",
+                 GuiH::Flags::Disabled);
+      GuiH::Info("Gaze", "", std::to_string(rtxState.gazePosition.x) + ", " + std::to_string(rtxState.gazePosition.y),
+                 GuiH::Flags::Disabled);
+      return false;
+    });
+
+    // The controller adjusts the active profile, back to it as authored when disabled
+    FoveationBudget& budget = _se->m_foveaBudget;
+    bool             adjust = GuiH::Checkbox("Foveation Budget", "Shrink the rings and trace the periphery less often to stay within a GPU time per trace",
+                                             &budget.m_enable, nullptr);
+    if(adjust && !budget.m_enable)
+      budget.reset();
+    if(budget.m_enable)
+    {
+      GuiH::Group<bool>("Budget", true, [&] {
+        GuiH::Slider("Budget (ms)", "GPU time of a frame, of all its tiles for the tiled trace", &budget.m_budgetMs,
+                     nullptr, Normal, 1.f, 100.f);
+        adjust |= GuiH::Slider("Min Fovea", "Radius traced as the fovea whatever the budget, in degrees",
+                               &budget.m_minFoveaDeg, nullptr, Normal, 0.f, 20.f);
+        GuiH::Info("Level", "0: profile as authored, 1: most reduced", std::to_string(budget.getLevel()), GuiH::Flags::Disabled);
+        GuiH::Info("Rings", "Scale of the ring radii and of the frame intervals",
+                   std::to_string(budget.getRadiusScale()) + ", x" + std::to_string(budget.getIntervalScale()),
+                   GuiH::Flags::Disabled);
+        const auto& history = budget.getHistory();
+        ImGui::PlotLines("##TraceTime", history.data(), static_cast<int>(history.size()), budget.getHistoryOffset(),
+                         (std::to_string(budget.getAverage()) + " ms").c_str(), 0.f, budget.m_budgetMs * 2.f, ImVec2(0, 40));
+        return false;
+      });
+    }
+    if(adjust)
+      _se->m_foveation.adjust(budget.getRadiusScale(), budget.getIntervalScale(), budget.m_enable ? budget.m_minFoveaDeg : 0.f);
+  }
+  changed |= GuiH::Checkbox("Adaptive Sampling", "Stop tracing converged pixels, more samples where the noise is",
+                            (bool*)&rtxState.enableAdaptiveSampling, nullptr);
+  if(rtxState.enableAdaptiveSampling)
+  {
+    changed |= GuiH::Group<bool>("Convergence", true, [&] {
+      bool c = false;
+      c |= GuiH::Slider("Error Threshold", "Relative standard error of the luminance under which a pixel is converged",
+                        &rtxState.convergenceThreshold, nullptr, Normal, 0.001f, 0.1f);
+      c |= GuiH::Slider("Min Samples", "Samples before the error of a pixel is estimated", &rtxState.minPixelSamples,
+                        nullptr, Normal, 2, 256);
+      c |= GuiH::Slider("Max Boost", "Noisy pixels get up to this many times the samples per frame",
+                        &rtxState.maxSampleBoost, nullptr, Normal, 1, 16);
+      uint32_t active = _se->m_pixelSelect.getActivePixels();
+      GuiH::Info("Active Pixels", "", active == ~0u ? std::string("-") : std::to_string(active), GuiH::Flags::Disabled);
+      return c;
+    });
+  }
+  // Only used on the next camera motion, nothing to restart
+  GuiH::Checkbox("Reprojection", "Camera motion moves the accumulated samples instead of discarding them",
+                 (bool*)&rtxState.enableReprojection, nullptr);
+  if(rtxState.enableReprojection)
+  {
+    GuiH::Slider("Max History", "Samples kept by the reprojection, older ones fade out", &rtxState.maxHistorySamples,
+                 nullptr, Normal, 1, 4096);
+  }
+  // Restarting, the tiles of the current pass are left unfinished
+  TileScheduler& tiles = _se->m_tiles;
+  changed |= GuiH::Checkbox("Tiled Trace", "Trace the tiles fitting in a GPU time budget, nearest to the fovea first",
+                            &tiles.m_enable, nullptr);
+  if(tiles.m_enable)
+  {
+    GuiH::Group<bool>("Tiles", true, [&] {
+      GuiH::Slider("Budget (ms)", "GPU time of the tiles traced at once, the others are carried over", &tiles.m_budgetMs,
+                   nullptr, Normal, 0.5f, 50.f);
+      GuiH::Info("Tiles", "Traced last time / per frame",
+                 std::to_string(tiles.getTraced()) + " / " + std::to_string(tiles.getTileCount()), GuiH::Flags::Disabled);
+      GuiH::Info("GPU Time", "Of the tiles traced last time, and per tile on average",
+                 std::to_string(tiles.getLastTime()) + " ms, " + std::to_string(tiles.getTileCost()) + " ms",
+                 GuiH::Flags::Disabled);
+      return false;
+    });
+  }
+  DynamicResolution& dynRes = _se->m_dynResolution;
+  if(GuiH::Checkbox("Dynamic Resolution", "Scale the traced extent to keep the GPU time of a trace on target",
+                    &dynRes.m_enable, nullptr))
+  {
+    dynRes.reset();
+    changed = true;
+  }
+  if(dynRes.m_enable)
+  {
+    // The controller restarts the accumulation when the scale changes
+    GuiH::Group<bool>("Resolution", true, [&] {
+      if(rtxState.enableFoveation && _se->m_foveaBudget.m_enable)
+        GuiH::Info("Target (ms)", "The foveation budget: the scale only drops once the foveation is at its most reduced",
+                   std::to_string(_se->m_foveaBudget.m_budgetMs), GuiH::Flags::Disabled);
+      else
+        GuiH::Slider("Target (ms)", "GPU time of a frame, of all its tiles for the tiled trace", &dynRes.m_targetMs,
+                     nullptr, Normal, 1.f, 100.f);
+      GuiH::Slider("Min Scale", "Lowest scale of the width and height", &dynRes.m_minScale, nullptr, Normal, 0.1f, 1.f);
+      GuiH::Slider("Band", "Relative distance to the target without change", &dynRes.m_band, nullptr, Normal, 0.f, 0.5f);
+      GuiH::Info("Scale", "", std::to_string(dynRes.getScale()), GuiH::Flags::Disabled);
+      GuiH::Info("Trace", "Traced extent and average GPU time",
+                 std::to_string(_se->m_traceSize.width) + "x" + std::to_string(_se->m_traceSize.height) + ", "
+                     + std::to_string(dynRes.getAverage()) + " ms",
+                 GuiH::Flags::Disabled);
+      return false;
+    });
+  }
   changed |= GuiH::Slider("Max Ray Depth", "", &rtxState.maxDepth, nullptr, Normal, 1, 10);
   changed |= GuiH::Slider("Samples Per Frame", "", &rtxState.maxSamples, nullptr, Normal, 1, 10);
   changed |= GuiH::Slider("Max Iteration ", "", &_se->m_maxFrames, nullptr, Normal, 1, 100000);
 
   changed |= GuiH::Selection("Pbr Mode", "PBR material model", &rtxState.pbrMode, nullptr, Normal, {"Disney", "Gltf"});
 
+  // All backends trace the same paths, for comparing them on the same scene
+  if(_se->m_supportRayQuery)
+  {
+    int rndMethod = _se->m_rndMethod;
+    if(GuiH::Selection("Renderer", "Ray tracing pipeline, compute shader with ray queries, or the path tracer split in kernels",
+                       &rndMethod, nullptr, Normal, {"RtxPipeline", "Ray Query", "Wavefront"}))
+    {
+      _se->createRender(static_cast<Raytracer::RndMethod>(rndMethod));
+      changed = true;
+    }
+  }
+
   static bool bAnyHit = true;
   if(_se->m_rndMethod == Raytracer::RndMethod::eRtxPipeline)
   {
-    if(GuiH::Checkbox("Enable AnyHit", "AnyHit is used for double sided, cutout opacity, but can be slower when all objects are opaque",
+    if(GuiH::Checkbox("Enable AnyHit", "AnyHit is used by the alpha mask materials for cutout opacity, disabling it makes them opaque",
                       &bAnyHit, nullptr))
     {
       auto rtx = dynamic_cast<RtxPipeline*>(_se->m_pRender[_se->m_rndMethod]);
@@ -103,6 +279,130 @@ bool GUI::guiRayTracing()
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// GPU time of the profiled scopes over the last submissions, in ms
+//
+void GUI::guiProfiler()
+{
+  // Ray counters of the last traces
+  auto& rtxState = _se->m_rtxState;
+  GuiH::Group<bool>("Rays", true, [&] {
+    GuiH::Checkbox("Count Rays", "Rays and pixels counted by the shaders, read back after each trace",
+                   (bool*)&rtxState.enableRayCounters, nullptr);
+    if(rtxState.enableRayCounters == 0)
+      return false;
+
+    const RayStats&    rays = _se->m_rayStats;
+    const RayCounters& last = rays.getLast();
+    GuiH::Info("Rays/s", "Primary, extension and shadow rays over the GPU time of the trace",
+               FormatNumbers(uint64_t(rays.getRaysPerSecond())), GuiH::Flags::Disabled);
+    GuiH::Info("Skipped", "Pixels considered by the selection and not traced (foveation, convergence)",
+               std::to_string(int(rays.getSkipRatio() * 100.f + 0.5f)) + " %", GuiH::Flags::Disabled);
+    GuiH::Info("Primary", "", FormatNumbers(last.primary), GuiH::Flags::Disabled);
+    GuiH::Info("Extension", "", FormatNumbers(last.extension), GuiH::Flags::Disabled);
+    GuiH::Info("Shadow", "", FormatNumbers(last.shadow), GuiH::Flags::Disabled);
+    GuiH::Info("Any Hit", "Any hit invocations, alpha tested candidates", FormatNumbers(last.anyHit), GuiH::Flags::Disabled);
+    GuiH::Info("Pixels", "", FormatNumbers(last.pixels), GuiH::Flags::Disabled);
+    GuiH::Custom("Mrays/s", "Last traces", [&] {
+      const auto& history = rays.getHistory();
+      ImGui::PlotLines("##RaysHistory", history.data(), static_cast<int>(history.size()), rays.getHistoryOffset(),
+                       nullptr, 0.f, FLT_MAX, ImVec2(0, 40));
+      return false;
+    });
+    return false;
+  });
+
+  auto stats = GpuProfiler::get().getStats();
+  if(stats.empty())
+  {
+    ImGui::TextWrapped("No GPU timings yet");
+    return;
+  }
+
+  if(ImGui::BeginTable("##GpuProfiler", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+  {
+    ImGui::TableSetupColumn("Section", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Min");
+    ImGui::TableSetupColumn("Avg");
+    ImGui::TableSetupColumn("P99");
+    ImGui::TableHeadersRow();
+    for(const auto& s : stats)
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(s.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", s.minMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", s.avgMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", s.p99Ms);
+    }
+    ImGui::EndTable();
+  }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Heatmap debug view: the clock cost of the pixels replaces the image, the most expensive
+// materials since the last reset are listed
+//
+bool GUI::guiHeatmap()
+{
+  auto&    rtxState = _se->m_rtxState;
+  Heatmap& heatmap  = _se->m_heatmap;
+  bool     changed{false};
+
+  GuiH::Group<bool>("Heatmap", true, [&] {
+    if(GuiH::Checkbox("Show Costs", "Clock cost of the pixels instead of the radiance, blue is cheap and red expensive",
+                      (bool*)&rtxState.heatmap, nullptr))
+    {
+      heatmap.reset();
+      changed = true;
+    }
+    if(rtxState.heatmap == 0)
+      return false;
+
+    if(_se->m_rndMethod == Raytracer::eWavefront)
+      ImGui::TextWrapped("Wavefront: only the shading of the materials is timed, not the pixels");
+    GuiH::Info("Max Cost", "Clock ticks of the most expensive pixel, shown in red",
+               FormatNumbers(uint64_t(heatmap.getMaxPixelCost())), GuiH::Flags::Disabled);
+    GuiH::Info("Traces", "Traces summed in the material costs", std::to_string(heatmap.getTraces()), GuiH::Flags::Disabled);
+    return false;
+  });
+  if(rtxState.heatmap == 0)
+    return changed;
+
+  auto materials = heatmap.getMaterials(10);
+  if(!materials.empty() && ImGui::BeginTable("##HeatmapMaterials", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+  {
+    ImGui::TableSetupColumn("Material", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Share");
+    ImGui::TableSetupColumn("Ticks/Hit");
+    ImGui::TableHeadersRow();
+    for(const auto& m : materials)
+    {
+      std::string name = m.material < 0 ? "Environment" : _se->m_scene.getMaterialName(m.material);
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f %%", heatmap.getTotalTicks() > 0 ? 100.0 * double(m.ticks) / double(heatmap.getTotalTicks()) : 0.0);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.0f", double(m.ticks) / double(m.hits));
+    }
+    ImGui::EndTable();
+  }
+
+  if(ImGui::Button("Reset"))
+    heatmap.reset();
+  ImGui::SameLine();
+  if(ImGui::Button("Save Report"))
+    heatmap.writeReport(heatmap.m_reportFile, [&](int i) { return _se->m_scene.getMaterialName(i); });
+  return changed;
+}
+
+
 bool GUI::guiTonemapper()
 {
   static Tonemapper default_tm{
@@ -110,7 +410,10 @@ bool GUI::guiTonemapper()
       1.0f,          // contrast;
       1.0f,          // saturation;
       1.0f,          // avgLum;
-      0             // autoExposure;
+      0,             // autoExposure;
+      0,             // heatmap
+      {1.0f, 1.0f},  // uvScale
+      {1.0f, 1.0f},  // uvMax
   };
 
   auto&     tm = _se->m_offscreen.m_tonemapper;
@@ -16,9 +16,12 @@ public:
   void showBusyWindow();
 
 private:
+  void           guiCameraPath();
   bool           guiRayTracing();
   bool           guiTonemapper();
   bool           guiEnvironment();
+  void           guiProfiler();
+  bool           guiHeatmap();
   void           loadSceneWindow();
 
 
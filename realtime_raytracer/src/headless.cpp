@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Rendering without window: the trace accumulates in the offscreen images, the results are
+ *  written to disk at the end.
+ */
+
+
+#include "headless.hpp"
+#include "nvvk/images_vk.hpp"
+#include "raytracer.hpp"
+#include "stb_image_write.h"
+#include "tools.hpp"
+
+
+//--------------------------------------------------------------------------------------------------
+// Render pass and images of the tonemapper, in place of the ones of the swapchain
+//
+void Headless::setup(const VkExtent2D& size)
+{
+  _se->m_size = size;
+
+  VkAttachmentDescription color{};
+  color.format         = m_format;
+  color.samples        = VK_SAMPLE_COUNT_1_BIT;
+  color.loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  color.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
+  color.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  color.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+  color.finalLayout    = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;  // Copied to the readback buffer
+
+  VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+  VkSubpassDescription  subpass{};
+  subpass.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments    = &colorRef;
+
+  VkSubpassDependency dependency{};
+  dependency.srcSubpass    = 0;
+  dependency.dstSubpass    = VK_SUBPASS_EXTERNAL;
+  dependency.srcStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependency.dstStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+  VkRenderPassCreateInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
+  renderPassInfo.attachmentCount = 1;
+  renderPassInfo.pAttachments    = &color;
+  renderPassInfo.subpassCount    = 1;
+  renderPassInfo.pSubpasses      = &subpass;
+  renderPassInfo.dependencyCount = 1;
+  renderPassInfo.pDependencies   = &dependency;
+  vkCreateRenderPass(_se->m_device, &renderPassInfo, nullptr, &_se->m_renderPass);  // Destroyed with the application
+
+  createTarget();
+
+  // Same as createOffscreenRender, without the axis
+  _se->m_offscreen.create(size, _se->m_renderPass);
+  _se->m_pixelSelect.createReadback();
+  _se->setRenderRegion({{}, size});
+
+  VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+  poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  poolInfo.queueFamilyIndex = _se->m_graphicsQueueIndex;
+  vkCreateCommandPool(_se->m_device, &poolInfo, nullptr, &m_cmdPool);
+
+  VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+  allocInfo.commandPool        = m_cmdPool;
+  allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  allocInfo.commandBufferCount = 1;
+  vkAllocateCommandBuffers(_se->m_device, &allocInfo, &m_cmdBuf);
+}
+
+void Headless::createTarget()
+{
+  Allocator&        alloc = _se->m_alloc;
+  const VkExtent2D& size  = _se->m_size;
+
+  VkImageCreateInfo imageInfo = nvvk::makeImage2DCreateInfo(size, m_format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+  m_target = alloc.createImage(imageInfo);
+  VkImageViewCreateInfo viewInfo = nvvk::makeImageViewCreateInfo(m_target.image, imageInfo);
+  vkCreateImageView(_se->m_device, &viewInfo, nullptr, &m_targetView);
+
+  VkFramebufferCreateInfo framebufferInfo{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+  framebufferInfo.renderPass      = _se->m_renderPass;
+  framebufferInfo.attachmentCount = 1;
+  framebufferInfo.pAttachments    = &m_targetView;
+  framebufferInfo.width           = size.width;
+  framebufferInfo.height          = size.height;
+  framebufferInfo.layers          = 1;
+  vkCreateFramebuffer(_se->m_device, &framebufferInfo, nullptr, &m_framebuffer);
+
+  VkMemoryPropertyFlags hostFlags =
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  VkDeviceSize pixels = VkDeviceSize(size.width) * size.height;
+  m_ldrReadback       = alloc.createBuffer(pixels * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, hostFlags);
+  m_hdrReadback       = alloc.createBuffer(pixels * 4 * sizeof(float), VK_BUFFER_USAGE_TRANSFER_DST_BIT, hostFlags);
+}
+
+void Headless::destroy()
+{
+  Allocator& alloc = _se->m_alloc;
+  alloc.destroy(m_target);
+  alloc.destroy(m_ldrReadback);
+  alloc.destroy(m_hdrReadback);
+  vkDestroyImageView(_se->m_device, m_targetView, nullptr);
+  vkDestroyFramebuffer(_se->m_device, m_framebuffer, nullptr);
+  vkDestroyCommandPool(_se->m_device, m_cmdPool, nullptr);
+
+  m_targetView  = VK_NULL_HANDLE;
+  m_framebuffer = VK_NULL_HANDLE;
+  m_cmdPool     = VK_NULL_HANDLE;
+  m_cmdBuf      = VK_NULL_HANDLE;
+}
+
+//--------------------------------------------------------------------------------------------------
+// One submission per trace, in place of the display frames: resolving the completed trace and
+// starting the next one. Waiting for both, there is nothing else to do meanwhile.
+//
+int Headless::run(int maxFrames, float maxSeconds, const std::string& output)
+{
+  if(maxFrames > 0)
+    _se->m_maxFrames = maxFrames;
+
+  // Replaying a camera path: until its end, whatever the number of frames
+  bool playback = _se->m_cameraPath.isPlaying();
+
+  MilliTimer timer;
+  bool       done = false;
+  while(!done)
+  {
+    // The last submission only resolves the trace, and tonemaps it
+    if(playback)
+      done = !_se->m_cameraPath.isPlaying();
+    else
+      done = _se->m_rtxState.frame + 1 >= _se->m_maxFrames;
+    done |= maxSeconds > 0.f && timer.elapsed() >= maxSeconds * 1000.0;
+    frame(done);
+  }
+
+  int frames = _se->m_rtxState.frame + 1;
+  LOGI("Headless: %d frames of %ux%u in %.3f s\n", frames, _se->m_size.width, _se->m_size.height, timer.elapsed() / 1000.0);
+  if(frames <= 0)
+  {
+    LOGE("Headless: nothing was traced\n");
+    return 1;
+  }
+  return writeOutput(output) ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+// One submission: resolving the completed trace, then tracing the next one or tonemapping the
+// result for writeOutput. Returns true if a trace was resolved (AsyncCompute::getTraceTime).
+//
+bool Headless::frame(bool output)
+{
+  VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkResetCommandBuffer(m_cmdBuf, 0);
+  vkBeginCommandBuffer(m_cmdBuf, &beginInfo);
+
+  _se->preparePost(m_cmdBuf);
+  bool resolved = _se->m_asyncCompute.hasResolve();
+  if(output)
+    recordOutput(m_cmdBuf);
+  else
+    _se->traceFrame();
+  submit(m_cmdBuf);
+  return resolved;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Same semaphores as Raytracer::submitFrame, without the swapchain
+//
+void Headless::submit(VkCommandBuffer cmdBuf)
+{
+  vkEndCommandBuffer(cmdBuf);
+
+  AsyncCompute&              async     = _se->m_asyncCompute;
+  const uint64_t             value     = async.getResolveValue();
+  const VkSemaphore          traced    = async.getTraced();
+  const VkSemaphore          resolved  = async.getResolved();
+  const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.waitSemaphoreValueCount   = 1;
+  timelineInfo.pWaitSemaphoreValues      = &value;
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues    = &value;
+
+  VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers    = &cmdBuf;
+  if(async.hasResolve())
+  {
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.pWaitSemaphores      = &traced;
+    submitInfo.pWaitDstStageMask    = &waitStage;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &resolved;
+  }
+
+  vkQueueSubmit(_se->m_queue, 1, &submitInfo, VK_NULL_HANDLE);
+  vkDeviceWaitIdle(_se->m_device);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Tonemapping in the offscreen target, and copying both results for the host
+//
+void Headless::recordOutput(VkCommandBuffer cmdBuf)
+{
+  const VkExtent2D& size = _se->m_size;
+
+  VkClearValue          clearValue{};
+  VkRenderPassBeginInfo renderPassInfo{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+  renderPassInfo.renderPass      = _se->m_renderPass;
+  renderPassInfo.framebuffer     = m_framebuffer;
+  renderPassInfo.renderArea      = {{}, size};
+  renderPassInfo.clearValueCount = 1;
+  renderPassInfo.pClearValues    = &clearValue;
+  vkCmdBeginRenderPass(cmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+  _se->drawPost(cmdBuf);
+  vkCmdEndRenderPass(cmdBuf);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent      = {size.width, size.height, 1};
+  vkCmdCopyImageToBuffer(cmdBuf, m_target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ldrReadback.buffer, 1, &region);
+
+  _se->m_offscreen.copyToBuffer(cmdBuf, m_hdrReadback.buffer);
+}
+
+//--------------------------------------------------------------------------------------------------
+// <output>.png: tonemapped, <output>.hdr: linear radiance
+//
+bool Headless::writeOutput(const std::string& output)
+{
+  Allocator&        alloc = _se->m_alloc;
+  const VkExtent2D& size  = _se->m_size;
+  int               w     = static_cast<int>(size.width);
+  int               h     = static_cast<int>(size.height);
+
+  std::string ldrName = output + ".png";
+  std::string hdrName = output + ".hdr";
+  void*       ldr     = alloc.map(m_ldrReadback);
+  bool        ok      = stbi_write_png(ldrName.c_str(), w, h, 4, ldr, w * 4) != 0;
+  alloc.unmap(m_ldrReadback);
+  auto* hdr = static_cast<float*>(alloc.map(m_hdrReadback));
+  ok &= stbi_write_hdr(hdrName.c_str(), w, h, 4, hdr) != 0;
+  alloc.unmap(m_hdrReadback);
+
+  if(!ok)
+  {
+    LOGE("Headless: cannot write %s / %s\n", ldrName.c_str(), hdrName.c_str());
+    return false;
+  }
+  LOGI("Headless: wrote %s and %s\n", ldrName.c_str(), hdrName.c_str());
+  return true;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <string>
+
+#include "nvvk/resourceallocator_vk.hpp"
+
+
+class Raytracer;
+
+/*
+
+Offline rendering, without window nor swapchain (e.g. on a software Vulkan ICD)
+* The trace runs as in the interactive mode (AsyncCompute), the display frames are replaced by
+  submissions resolving each completed trace. The tonemapper draws in an offscreen target
+  instead of the swapchain.
+* Stops after a number of frames, at the end of the camera path being played, or after a time
+  budget, then writes the tonemapped result (PNG) and the linear one (Radiance HDR).
+
+* Usage
+  - setup, instead of the swapchain, render pass and framebuffers
+  - load the scene and create the renderer as usual
+  - run: returns the exit status. Or frame for each submission, then writeOutput after the
+    last one (output = true).
+  - destroy, before the resources of the ray tracer
+*/
+class Headless
+{
+public:
+  Headless(Raytracer* _s)
+      : _se(_s)
+  {
+  }
+  void setup(const VkExtent2D& size);
+  void destroy();
+  int  run(int maxFrames, float maxSeconds, const std::string& output);
+  bool frame(bool output);
+  bool writeOutput(const std::string& output);
+
+private:
+  void createTarget();
+  void submit(VkCommandBuffer cmdBuf);
+  void recordOutput(VkCommandBuffer cmdBuf);
+
+  Raytracer* _se{nullptr};
+
+  VkFormat        m_format{VK_FORMAT_R8G8B8A8_UNORM};  // Tonemapped, the post shader applies the gamma
+  nvvk::Image     m_target;
+  VkImageView     m_targetView{VK_NULL_HANDLE};
+  VkFramebuffer   m_framebuffer{VK_NULL_HANDLE};
+  VkCommandPool   m_cmdPool{VK_NULL_HANDLE};
+  VkCommandBuffer m_cmdBuf{VK_NULL_HANDLE};
+  nvvk::Buffer    m_ldrReadback;
+  nvvk::Buffer    m_hdrReadback;
+};
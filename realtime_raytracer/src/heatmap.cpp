@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Clock cost of the pixels and materials, read back without waiting for the GPU
+ */
+
+
+#include <algorithm>
+#include <fstream>
+
+#include "heatmap.hpp"
+#include "tools.hpp"
+
+
+void Heatmap::setup(const VkDevice& device, nvvk::ResourceAllocator* allocator)
+{
+  m_device = device;
+  m_pAlloc = allocator;
+  m_debug.setup(device);
+  reset();
+}
+
+void Heatmap::create()
+{
+  m_stats = m_pAlloc->createBuffer(sizeof(HeatmapStats),
+                                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_stats.buffer);
+
+  m_readback = m_pAlloc->createBuffer(sizeof(HeatmapStats), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                          | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  NAME_VK(m_readback.buffer);
+  m_readbackData = static_cast<HeatmapStats*>(m_pAlloc->map(m_readback));
+  m_pending      = false;
+}
+
+void Heatmap::destroy()
+{
+  if(m_readbackData != nullptr)
+    m_pAlloc->unmap(m_readback);
+  m_pAlloc->destroy(m_readback);
+  m_pAlloc->destroy(m_stats);
+  m_readbackData = nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Clearing the stats before the trace, all its passes add to them
+//
+void Heatmap::begin(const VkCommandBuffer& cmdBuf)
+{
+  vkCmdFillBuffer(cmdBuf, m_stats.buffer, 0, VK_WHOLE_SIZE, 0);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0, 1, &mb,
+                       0, nullptr, 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Copy for the host, read by update once the trace is done
+//
+void Heatmap::end(const VkCommandBuffer& cmdBuf)
+{
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkBufferCopy region{0, 0, sizeof(HeatmapStats)};
+  vkCmdCopyBuffer(cmdBuf, m_stats.buffer, m_readback.buffer, 1, &region);
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+  m_pending = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The trace is completed: adding its material costs to the sums. The color scale follows the
+// most expensive pixel, smoothed to not flicker with the pixels traced by each frame.
+//
+bool Heatmap::update()
+{
+  if(!m_pending || m_readbackData == nullptr)
+    return false;
+  m_pending = false;
+
+  const HeatmapStats& stats = *m_readbackData;
+  auto                add   = [&](MaterialCost& sum, const HeatmapMaterial& m) {
+    uint64_t ticks = uint64_t(m.cost) << HeatmapCostShift;
+    sum.ticks += ticks;
+    sum.hits += m.hits;
+    m_totalTicks += ticks;
+  };
+  for(int i = 0; i < HeatmapMaxMaterials; i++)
+    add(m_materials[i], stats.materials[i]);
+  add(m_materials.back(), stats.environment);
+
+  if(stats.maxPixelCost > 0)
+    m_maxPixelCost = m_maxPixelCost > 0.f ? m_maxPixelCost * 0.8f + float(stats.maxPixelCost) * 0.2f : float(stats.maxPixelCost);
+  m_traces++;
+  return true;
+}
+
+void Heatmap::reset()
+{
+  m_materials.assign(HeatmapMaxMaterials + 1, MaterialCost{});
+  for(int i = 0; i < HeatmapMaxMaterials; i++)
+    m_materials[i].material = i;
+  m_materials.back().material = -1;
+  m_totalTicks                = 0;
+  m_traces                    = 0;
+  m_maxPixelCost              = 0.f;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The materials hit since the reset, most expensive first
+//
+std::vector<Heatmap::MaterialCost> Heatmap::getMaterials(size_t maxCount) const
+{
+  std::vector<MaterialCost> result;
+  for(const auto& m : m_materials)
+  {
+    if(m.hits > 0)
+      result.push_back(m);
+  }
+  std::sort(result.begin(), result.end(), [](const MaterialCost& a, const MaterialCost& b) { return a.ticks > b.ticks; });
+  if(result.size() > maxCount)
+    result.resize(maxCount);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+// CSV of the material costs, most expensive first
+//
+bool Heatmap::writeReport(const std::string& filename, const std::function<std::string(int)>& materialName) const
+{
+  std::ofstream out(filename, std::ios::trunc);
+  if(!out.is_open())
+  {
+    LOGE("Cannot write the heatmap report: %s\n", filename.c_str());
+    return false;
+  }
+
+  out << "material,name,hits,ticks,ticksPerHit,share\n";
+  for(const auto& m : getMaterials())
+  {
+    std::string name = m.material < 0 ? "environment" : materialName(m.material);
+    std::replace(name.begin(), name.end(), ',', ' ');
+    out << m.material << ',' << name << ',' << m.hits << ',' << m.ticks << ',' << double(m.ticks) / double(m.hits) << ','
+        << (m_totalTicks > 0 ? double(m.ticks) / double(m_totalTicks) : 0.0) << '\n';
+  }
+  LOGI("Heatmap report of %u traces: %s\n", m_traces, filename.c_str());
+  return true;
+}
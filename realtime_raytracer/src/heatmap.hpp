@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "nvvk/debug_util_vk.hpp"
+#include "nvvk/resourceallocator_vk.hpp"
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Heatmap debug view: where the frame time goes, per pixel and per material
+* The path tracer reads the shader clock (clockARB, shaders/heatmap.glsl) around each pixel and
+  each bounce. The pixel cost is averaged over the last traces and displayed with temperature
+  colors instead of the radiance; the bounce cost is summed per material hit (HeatmapStats).
+* The stats are cleared at the start of each trace and copied to a host visible buffer at its
+  end, read once the trace is seen completed as for the ray counters (RayStats).
+* The color scale follows the highest pixel cost, red is the most expensive pixel.
+* The material costs are summed from the last reset: the top materials for the GUI, and all of
+  them in a CSV report.
+* The wavefront renderer has no per-pixel cost, its kernels run separately: only the shading of
+  the materials is timed.
+
+* Usage
+  - setup, create; destroy
+  - getBuffer: bound to the environment set (EnvBindings::eHeatmapStats)
+  - begin and end in the command buffer of the trace, when RtxState::heatmap is set
+  - update for each completed trace, then getScale for RtxState::heatmapScale
+  - reset when the materials change (new scene)
+*/
+class Heatmap
+{
+public:
+  struct MaterialCost
+  {
+    int      material{0};  // Index in the scene, -1 for the environment
+    uint64_t ticks{0};     // Clock ticks of the bounces on the material
+    uint64_t hits{0};      // Bounces on the material
+  };
+
+  void     setup(const VkDevice& device, nvvk::ResourceAllocator* allocator);
+  void     create();
+  void     destroy();
+  VkBuffer getBuffer() const { return m_stats.buffer; }
+
+  void begin(const VkCommandBuffer& cmdBuf);
+  void end(const VkCommandBuffer& cmdBuf);
+  bool update();
+  void reset();
+
+  float                     getScale() const { return m_maxPixelCost > 0.f ? 1.f / m_maxPixelCost : 0.f; }
+  float                     getMaxPixelCost() const { return m_maxPixelCost; }  // Averaged, in clock ticks
+  uint32_t                  getTraces() const { return m_traces; }             // Traces summed since the reset
+  uint64_t                  getTotalTicks() const { return m_totalTicks; }
+  std::vector<MaterialCost> getMaterials(size_t maxCount = ~size_t(0)) const;  // Most expensive first
+
+  bool writeReport(const std::string& filename, const std::function<std::string(int)>& materialName) const;
+
+  std::string m_reportFile{"heatmap.csv"};  // Report saved from the GUI, and at exit with -heatmap
+
+private:
+  nvvk::Buffer  m_stats;     // Written by the shaders
+  nvvk::Buffer  m_readback;  // Copy of the last trace
+  HeatmapStats* m_readbackData{nullptr};
+  bool          m_pending{false};  // A copy was recorded since the last update
+
+  std::vector<MaterialCost> m_materials;  // Sums since the reset, the environment is the last one
+  uint64_t                  m_totalTicks{0};
+  uint32_t                  m_traces{0};
+  float                     m_maxPixelCost{0};
+
+  nvvk::ResourceAllocator* m_pAlloc{nullptr};
+  nvvk::DebugUtil          m_debug;
+  VkDevice                 m_device{VK_NULL_HANDLE};
+};
@@ -7,6 +7,9 @@
 #include "nvh/fileoperations.hpp"
 #include "nvh/inputparser.h"
 #include "nvvk/context_vk.hpp"
+#include "gpu_profiler.hpp"
+#include "benchmark.hpp"
+#include "headless.hpp"
 #include "raytracer.hpp"
 
 // Default search path for shaders
@@ -25,24 +28,68 @@ int main(int argc, char** argv)
   //std::string sceneFile = parser.getString("-f", "casino_grand/scene.gltf");
   std::string sceneFile = parser.getString("-f", "bathroom_interior/scene.gltf");
   std::string hdrFilename = parser.getString("-e", "std_env.hdr");
+  // Gaze input: center, mouse, file:<trace>, udp:<port> or unix:<path>
+  std::string gazeInput = parser.getString("-gaze", "center");
+  // Foveation profiles, in degrees of visual angle
+  std::string foveaProfiles = parser.getString("-foveaProfiles", "foveation_profiles.txt");
+  // Display geometry for the visual angle of the foveation, in millimeters. Without a pixel pitch
+  // the angle is the one through the camera, following its field of view.
+  float displayPitch = parser.getFloat("-displayPitch", 0.f);
+  float viewDistance = parser.getFloat("-viewDistance", 600.f);
+  // CSV of the foveation budget controller, one line per trace
+  std::string foveaTelemetry = parser.getString("-foveaTelemetry", "");
+  // CSV of the GPU timings, one line per profiled section and submission
+  std::string profileCsv = parser.getString("-profileCsv", "");
+  // CSV of the ray counters, one line per trace: rays per kind, pixels traced and skipped
+  std::string rayTelemetry = parser.getString("-rayTelemetry", "");
+  // Heatmap debug view (see heatmap.hpp): the clock cost of the pixels instead of the image, the
+  // cost of the materials written to this CSV at exit
+  std::string heatmapReport = parser.getString("-heatmap", "");
+  // Camera path (see camera_path.hpp): recording the camera and gaze of each frame, written at
+  // exit, or replaying a path frame by frame with a fixed random seed per frame
+  std::string cameraRecord = parser.getString("-cameraRecord", "");
+  std::string cameraPlay   = parser.getString("-cameraPlay", "");
+  int         cameraSeed   = parser.getInt("-cameraSeed", 1);
+  // Renderer backend: rtx (ray tracing pipeline), rq (compute with ray queries) or wf (wavefront kernels)
+  std::string renderer = parser.getString("-renderer", "rtx");
+  // Offline rendering without window nor swapchain: accumulating -frames traces or for -seconds,
+  // the results are written to <-o>.png (tonemapped) and <-o>.hdr (linear)
+  bool        headless       = parser.exist("--headless");
+  int         headlessFrames = parser.getInt("-frames", 256);
+  float       headlessTime   = parser.getFloat("-seconds", 0.f);
+  std::string headlessOutput = parser.getString("-o", "render");
+  // Benchmark matrix (see benchmark.hpp), rendered headless: the reports are <-o>.json and <-o>.csv
+  std::string benchmarkFile = parser.getString("-benchmark", "");
+  if(!benchmarkFile.empty())
+  {
+    headless = true;
+    if(!parser.exist("-o"))
+      headlessOutput = "benchmark";
+  }
+  VkExtent2D  size{static_cast<uint32_t>(parser.getInt("-width", WINDOW_WIDTH)),
+                  static_cast<uint32_t>(parser.getInt("-height", WINDOW_HEIGHT))};
 
   // Setup GLFW window
-  if(glfwInit() == GLFW_FALSE)
+  GLFWwindow* window = nullptr;
+  if(!headless)
   {
-    char const* errMsg = nullptr;
-    glfwGetError(&errMsg);
-    fprintf(stderr, "GLFW Error %s\n", errMsg);
-    return 1;
+    if(glfwInit() == GLFW_FALSE)
+    {
+      char const* errMsg = nullptr;
+      glfwGetError(&errMsg);
+      fprintf(stderr, "GLFW Error %s\n", errMsg);
+      return 1;
+    }
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    window = glfwCreateWindow(size.width, size.height, PROJECT_NAME, nullptr, nullptr);
   }
-  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-  GLFWwindow* window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, PROJECT_NAME, nullptr, nullptr);
 
   // Setup camera
-  CameraManip.setWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+  CameraManip.setWindowSize(size.width, size.height);
   //CameraManip.setLookat({2.0, 2.0, -5.0}, {-1.0, 2.0, -1.0}, {0.000, 1.000, 0.000});
 
   // Setup Vulkan
-  if(glfwVulkanSupported() == GLFW_FALSE)
+  if(!headless && glfwVulkanSupported() == GLFW_FALSE)
   {
     fprintf(stderr, "GLFW: Vulkan Not Supported\n");
     return 1;
@@ -56,18 +103,19 @@ int main(int argc, char** argv)
       NVPSystem::exePath() + PROJECT_DOWNLOAD_RELDIRECTORY,
   };
 
-  // Vulkan required extensions
-  assert(glfwVulkanSupported() == GLFW_TRUE); 
-  uint32_t count{0};
-  auto     reqExtensions = glfwGetRequiredInstanceExtensions(&count);
-
   // Requesting Vulkan extensions and layers
   nvvk::ContextCreateInfo contextInfo(true);
   contextInfo.setVersion(1, 2); 
-  for(uint32_t ext_id = 0; ext_id < count; ext_id++)  
-    contextInfo.addInstanceExtension(reqExtensions[ext_id]);
+  if(!headless)
+  {
+    // Vulkan required extensions, for the window surface and the swapchain
+    uint32_t count{0};
+    auto     reqExtensions = glfwGetRequiredInstanceExtensions(&count);
+    for(uint32_t ext_id = 0; ext_id < count; ext_id++)
+      contextInfo.addInstanceExtension(reqExtensions[ext_id]);
+    contextInfo.addDeviceExtension("VK_KHR_swapchain");
+  }
   contextInfo.addInstanceExtension("VK_EXT_debug_utils", true);  
-  contextInfo.addDeviceExtension("VK_KHR_swapchain");            
 
   VkPhysicalDeviceShaderClockFeaturesKHR clockFeature{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR};
   contextInfo.addDeviceExtension("VK_KHR_shader_clock", false, &clockFeature);
@@ -77,10 +125,12 @@ int main(int argc, char** argv)
   contextInfo.addDeviceExtension("VK_KHR_acceleration_structure", false, &accelFeature);
   VkPhysicalDeviceRayTracingPipelineFeaturesKHR rtPipelineFeature{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR};
   contextInfo.addDeviceExtension("VK_KHR_ray_tracing_pipeline", false, &rtPipelineFeature);
+  contextInfo.addDeviceExtension("VK_KHR_pipeline_library");  // Linking the ray tracing pipelines from libraries
   VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR };
   contextInfo.addDeviceExtension("VK_KHR_ray_query", true/*Optional extension*/, &rayQueryFeatures);
   contextInfo.addDeviceExtension("VK_KHR_deferred_host_operations");
   contextInfo.addDeviceExtension("VK_KHR_buffer_device_address");
+  contextInfo.addDeviceExtension("VK_EXT_memory_budget", true);  // Memory usage of the benchmark
 
   // Extra queues for parallel load/build
   contextInfo.addRequestedQueue(contextInfo.defaultQueueGCT, 1, 1.0f);  // Loading scene - mipmap generation
@@ -98,9 +148,13 @@ int main(int argc, char** argv)
   Raytracer raytracer;
 
   // Window need to be opened to get the surface on which to draw
-  const VkSurfaceKHR surface = raytracer.getVkSurface(vkContext.m_instance, window);
-  vkContext.setGCTQueueWithPresent(surface);
-  raytracer.setupGlfwCallbacks(window);
+  VkSurfaceKHR surface = VK_NULL_HANDLE;
+  if(!headless)
+  {
+    surface = raytracer.getVkSurface(vkContext.m_instance, window);
+    vkContext.setGCTQueueWithPresent(surface);
+    raytracer.setupGlfwCallbacks(window);
+  }
 
   
   auto                     qGCT1 = vkContext.createQueue(contextInfo.defaultQueueGCT, "GCT1", 1.0f);
@@ -112,7 +166,84 @@ int main(int argc, char** argv)
 
   // Create app
   raytracer.setup(vkContext.m_instance, vkContext.m_device, vkContext.m_physicalDevice, queues);
-  raytracer.createSwapchain(surface, WINDOW_WIDTH, WINDOW_HEIGHT);
+  raytracer.m_supportRayQuery = vkContext.hasDeviceExtension(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+  Raytracer::RndMethod rndMethod = Raytracer::eRtxPipeline;
+  if(renderer == "rq" || renderer == "wf")
+  {
+    if(raytracer.m_supportRayQuery)
+      rndMethod = renderer == "rq" ? Raytracer::eRayQuery : Raytracer::eWavefront;
+    else
+      LOGW("VK_KHR_ray_query not supported, using the ray tracing pipeline\n");
+  }
+  if(!raytracer.m_gaze.create(gazeInput))
+    LOGW("Gaze input '%s' not available, using the screen center\n", gazeInput.c_str());
+  std::string foveaProfilesFile = nvh::findFile(foveaProfiles, defaultSearchPaths, true);
+  if(foveaProfilesFile.empty() || !raytracer.m_foveation.load(foveaProfilesFile))
+    LOGW("Foveation profiles '%s' not available, using the built-in profile\n", foveaProfiles.c_str());
+  raytracer.m_displayPixelPitchMm = displayPitch;
+  raytracer.m_viewDistanceMm      = viewDistance;
+  if(!foveaTelemetry.empty())
+    raytracer.m_foveaBudget.openTelemetry(foveaTelemetry);
+  if(!profileCsv.empty())
+    GpuProfiler::get().openCsv(profileCsv);
+  if(!rayTelemetry.empty())
+    raytracer.m_rayStats.openTelemetry(rayTelemetry);
+  if(!heatmapReport.empty())
+  {
+    raytracer.m_heatmap.m_reportFile = heatmapReport;
+    raytracer.m_rtxState.heatmap     = 1;
+  }
+  auto writeHeatmapReport = [&] {
+    if(!heatmapReport.empty())
+      raytracer.m_heatmap.writeReport(heatmapReport, [&](int i) { return raytracer.m_scene.getMaterialName(i); });
+  };
+  if(!cameraPlay.empty())
+  {
+    std::string cameraPathFile = nvh::findFile(cameraPlay, defaultSearchPaths, true);
+    if(cameraPathFile.empty() || !raytracer.m_cameraPath.load(cameraPathFile))
+      LOGW("Camera path '%s' not available\n", cameraPlay.c_str());
+    else
+      raytracer.m_cameraPath.play(static_cast<uint32_t>(cameraSeed));
+  }
+  else if(!cameraRecord.empty())
+  {
+    raytracer.m_cameraPath.m_filename = cameraRecord;
+    raytracer.m_cameraPath.startRecording();
+  }
+
+  if(headless)
+  {
+    // Everything on this thread, then tracing until done
+    Headless offline(&raytracer);
+    offline.setup(size);
+    int status = 0;
+    if(!benchmarkFile.empty())
+    {
+      Benchmark bench(&raytracer, &offline, vkContext.hasDeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME));
+      status = bench.run(benchmarkFile, rndMethod, headlessOutput);
+    }
+    else
+    {
+      raytracer.loadEnvironmentHdr(nvh::findFile(hdrFilename, defaultSearchPaths, true));
+      raytracer.loadScene(nvh::findFile(sceneFile, defaultSearchPaths, true));
+      raytracer.createUniformBuffer();
+      raytracer.createDescriptorSetLayout();
+      raytracer.createRender(rndMethod);
+      raytracer.resetFrame();
+      status = offline.run(headlessFrames, headlessTime, headlessOutput);
+    }
+
+    raytracer.m_cameraPath.stopRecording(raytracer.m_cameraPath.m_filename);
+    writeHeatmapReport();
+    vkDeviceWaitIdle(raytracer.getDevice());
+    offline.destroy();
+    raytracer.destroyResources();
+    raytracer.destroy();
+    vkContext.deinit();
+    return status;
+  }
+
+  raytracer.createSwapchain(surface, size.width, size.height);
   raytracer.createDepthBuffer();
   raytracer.createRenderPass();
   raytracer.createFrameBuffers();
@@ -130,7 +261,7 @@ int main(int argc, char** argv)
     raytracer.loadScene(nvh::findFile(sceneFile, defaultSearchPaths, true));
     raytracer.createUniformBuffer();
     raytracer.createDescriptorSetLayout();
-    raytracer.createRender(Raytracer::eRtxPipeline);
+    raytracer.createRender(rndMethod);
     raytracer.resetFrame();
     raytracer.m_busy = false;
   }).detach();
@@ -149,7 +280,6 @@ int main(int argc, char** argv)
 
     // Start rendering the scene
     raytracer.prepareFrame();  // Waits for a framebuffer to be available
-    raytracer.updateFrame();   // Increment/update rendering frame count
 
     // Start command buffer of this frame
     auto                   curFrame = raytracer.getCurFrame();
@@ -158,12 +288,15 @@ int main(int argc, char** argv)
     VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(cmdBuf, &beginInfo);
+    GpuProfiler::get().beginFrame(cmdBuf, raytracer.getQueueFamily());
 
     raytracer.renderGui();          
-    raytracer.updateUniformBuffer(cmdBuf);  // Updating UBOs
 
-    // Rendering Scene (ray tracing)
-    raytracer.renderScene(cmdBuf);
+    // Displaying the latest completed trace, copied and mipmapped outside of the render pass
+    raytracer.preparePost(cmdBuf);
+
+    // Rendering Scene (ray tracing) on the compute queue, at its own rate
+    raytracer.traceFrame();
 
     // Rendering pass in swapchain framebuffer + tone mapper, UI
     {
@@ -186,7 +319,10 @@ int main(int argc, char** argv)
 
       // Render the UI
       ImGui::Render();
-      ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuf);
+      {
+        auto profileScope = GpuProfiler::get().scope(cmdBuf, "ImGui");
+        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuf);
+      }
 
       vkCmdEndRenderPass(cmdBuf);
     }
@@ -200,6 +336,8 @@ int main(int argc, char** argv)
   }
 
   // Cleanup
+  raytracer.m_cameraPath.stopRecording(raytracer.m_cameraPath.m_filename);
+  writeHeatmapReport();
   vkDeviceWaitIdle(raytracer.getDevice());
   raytracer.destroyResources();
   raytracer.destroy();
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+
+/*
+ *  Reconstruction of the periphery, after the foveated ray tracing
+ */
+
+
+#include "gpu_profiler.hpp"
+#include "nvvk/shaders_vk.hpp"
+#include "periphery_blur.hpp"
+#include "tools.hpp"
+
+// Shaders
+#include "autogen/periphery_blur.comp.h"
+
+
+void PeripheryBlur::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator)
+{
+  m_device     = device;
+  m_pAlloc     = allocator;
+  m_queueIndex = familyIndex;
+  m_debug.setup(device);
+}
+
+void PeripheryBlur::destroy()
+{
+  for(auto& p : m_pipelines)
+  {
+    vkDestroyPipeline(m_device, p, nullptr);
+    p = VkPipeline();
+  }
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  m_pipelineLayout = VkPipelineLayout();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The layout is the same as the renderer, the shader uses the output (S_OUT) and the
+// foveation profile (S_ENV)
+//
+void PeripheryBlur::create(const std::vector<VkDescriptorSetLayout>& descSetLayouts)
+{
+  destroy();
+
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState)};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges    = &pushConstant;
+  pipelineLayoutCreateInfo.setLayoutCount         = static_cast<uint32_t>(descSetLayouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts            = descSetLayouts.data();
+  vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
+
+  VkShaderModule module = nvvk::createShaderModule(m_device, periphery_blur_comp, sizeof(periphery_blur_comp));
+
+  for(int vertical = 0; vertical < 2; vertical++)
+  {
+    VkSpecializationMapEntry specEntry{0, 0, sizeof(int)};
+    VkSpecializationInfo     specInfo{1, &specEntry, sizeof(int), &vertical};
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    computePipelineCreateInfo.layout                    = m_pipelineLayout;
+    computePipelineCreateInfo.stage                     = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+    computePipelineCreateInfo.stage.stage               = VK_SHADER_STAGE_COMPUTE_BIT;
+    computePipelineCreateInfo.stage.module              = module;
+    computePipelineCreateInfo.stage.pName               = "main";
+    computePipelineCreateInfo.stage.pSpecializationInfo = &specInfo;
+
+    vkCreateComputePipelines(m_device, m_pipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_pipelines[vertical]);
+    m_debug.setObjectName(m_pipelines[vertical], vertical ? "PeripheryBlurV" : "PeripheryBlurH");
+  }
+
+  vkDestroyShaderModule(m_device, module, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Horizontal pass from the accumulation, then vertical pass to the output image
+//
+void PeripheryBlur::run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  // The trace is done writing the accumulation
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0,
+                          static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState), &m_state);
+
+  // Horizontal: one workgroup per segment of row
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[0]);
+  vkCmdDispatch(cmdBuf, (size.width + (BlurBlockSize - 1)) / BlurBlockSize, size.height, 1);
+
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0,
+                       nullptr, 0, nullptr);
+
+  // Vertical: one workgroup per segment of column
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[1]);
+  vkCmdDispatch(cmdBuf, (size.height + (BlurBlockSize - 1)) / BlurBlockSize, size.width, 1);
+
+  // The output is copied to the displayed image by the resolve
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+}
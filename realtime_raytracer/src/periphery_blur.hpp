@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <array>
+
+#include "nvvk/resourceallocator_vk.hpp"
+#include "nvvk/debug_util_vk.hpp"
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Periphery reconstruction of the foveated ray tracing
+* Separable Gaussian over the resolved accumulation (shaders/periphery_blur.comp), with a kernel
+  radius driven by the eccentricity of the pixel and shrinking with its number of samples, taps
+  weighted by their number of samples. Writes the output image (eStore) that is
+  resolved to the display. The accumulation itself is never modified.
+* Two dispatches of the same shader, specialized for the horizontal and the vertical direction.
+
+* Usage
+  - setup as usual
+  - create, with the same descriptor set layouts as the renderer
+  - run, after the renderer
+*/
+class PeripheryBlur
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator);
+  void destroy();
+  void create(const std::vector<VkDescriptorSetLayout>& descSetLayouts);
+  void run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets);
+  void setPushContants(const RtxState& state) { m_state = state; }
+  void setPipelineCache(VkPipelineCache cache) { m_pipelineCache = cache; }
+
+private:
+  RtxState m_state{};
+
+  // Setup
+  nvvk::ResourceAllocator* m_pAlloc{nullptr};  // Allocator for buffer, images, acceleration structures
+  nvvk::DebugUtil          m_debug;            // Utility to name objects
+  VkDevice                 m_device{VK_NULL_HANDLE};
+  VkPipelineCache          m_pipelineCache{VK_NULL_HANDLE};
+  uint32_t                 m_queueIndex{0};
+
+  VkPipelineLayout          m_pipelineLayout{VK_NULL_HANDLE};
+  std::array<VkPipeline, 2> m_pipelines{};  // Horizontal, vertical
+};
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Persistent pipeline cache: loading, validating and saving the cache data
+ */
+
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "nvh/nvprint.hpp"
+#include "pipeline_cache.hpp"
+
+
+// Header of the file, before the data of the Vulkan pipeline cache
+struct PipelineCacheFileHeader
+{
+  uint32_t magic;
+  uint32_t dataSize;
+  uint32_t driverVersion;
+  uint8_t  deviceUUID[VK_UUID_SIZE];
+};
+
+static const uint32_t s_pipelineCacheMagic = 0x48435050;  // "PPCH"
+
+
+//--------------------------------------------------------------------------------------------------
+// The device identity the cache file is keyed on
+//
+void PipelineCache::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice)
+{
+  m_device = device;
+
+  VkPhysicalDeviceIDProperties idProperties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES};
+  VkPhysicalDeviceProperties2  properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+  properties.pNext = &idProperties;
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+  m_properties = properties.properties;
+  memcpy(m_deviceUUID, idProperties.deviceUUID, VK_UUID_SIZE);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Saving what was compiled during the run
+//
+void PipelineCache::destroy()
+{
+  if(m_cache == VK_NULL_HANDLE)
+    return;
+
+  save();
+  vkDestroyPipelineCache(m_device, m_cache, nullptr);
+  m_cache = VK_NULL_HANDLE;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Creating the cache with the data of the file, if it was written by the same device and driver
+//
+void PipelineCache::load(const std::string& filename)
+{
+  m_filename = filename;
+
+  std::vector<char> data;
+  if(!readFile(data))
+    data.clear();
+  else if(!isCompatible(data))
+  {
+    LOGW("Pipeline cache %s is from another device or driver, starting empty\n", filename.c_str());
+    data.clear();
+  }
+
+  VkPipelineCacheCreateInfo createInfo{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+  createInfo.initialDataSize = data.size();
+  createInfo.pInitialData    = data.data();
+  if(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS)
+  {
+    // The driver refused the data, the pipelines are compiled as if there was no file
+    createInfo.initialDataSize = 0;
+    createInfo.pInitialData    = nullptr;
+    vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache);
+  }
+  LOGI("Pipeline cache: %zu bytes from %s\n", data.size(), filename.c_str());
+}
+
+//--------------------------------------------------------------------------------------------------
+// Writing the header and the cache data, through a temporary file so that an interrupted write
+// never leaves a truncated cache
+//
+bool PipelineCache::save()
+{
+  if(m_cache == VK_NULL_HANDLE || m_filename.empty())
+    return false;
+
+  size_t dataSize{0};
+  vkGetPipelineCacheData(m_device, m_cache, &dataSize, nullptr);
+  std::vector<char> data(dataSize);
+  if(dataSize == 0 || vkGetPipelineCacheData(m_device, m_cache, &dataSize, data.data()) != VK_SUCCESS)
+    return false;
+
+  PipelineCacheFileHeader header{s_pipelineCacheMagic, static_cast<uint32_t>(dataSize), m_properties.driverVersion};
+  memcpy(header.deviceUUID, m_deviceUUID, VK_UUID_SIZE);
+
+  std::string   tempName = m_filename + ".tmp";
+  std::ofstream file(tempName, std::ios::binary | std::ios::trunc);
+  if(!file.is_open())
+  {
+    LOGW("Cannot write the pipeline cache: %s\n", tempName.c_str());
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(data.data(), static_cast<std::streamsize>(dataSize));
+  file.close();
+  if(!file)
+    return false;
+
+  std::remove(m_filename.c_str());
+  if(std::rename(tempName.c_str(), m_filename.c_str()) != 0)
+    return false;
+
+  LOGI("Pipeline cache: %zu bytes saved to %s\n", dataSize, m_filename.c_str());
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The cache data of the file, without the file header. False when there is no file.
+//
+bool PipelineCache::readFile(std::vector<char>& data)
+{
+  std::ifstream file(m_filename, std::ios::binary | std::ios::ate);
+  if(!file.is_open())
+    return false;
+
+  std::streamsize fileSize = file.tellg();
+  PipelineCacheFileHeader header{};
+  file.seekg(0);
+  if(fileSize < static_cast<std::streamsize>(sizeof(header)) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    return false;
+
+  // Keyed on the device and driver, the data must be complete
+  if(header.magic != s_pipelineCacheMagic || header.driverVersion != m_properties.driverVersion
+     || memcmp(header.deviceUUID, m_deviceUUID, VK_UUID_SIZE) != 0
+     || static_cast<std::streamsize>(header.dataSize) != fileSize - static_cast<std::streamsize>(sizeof(header)))
+  {
+    data.clear();  // Reported as incompatible
+    return true;
+  }
+
+  data.resize(header.dataSize);
+  return static_cast<bool>(file.read(data.data(), header.dataSize));
+}
+
+//--------------------------------------------------------------------------------------------------
+// Validating the header written by the driver (VkPipelineCacheHeaderVersionOne)
+//
+bool PipelineCache::isCompatible(const std::vector<char>& data)
+{
+  VkPipelineCacheHeaderVersionOne header{};
+  if(data.size() < sizeof(header))
+    return false;
+  memcpy(&header, data.data(), sizeof(header));
+
+  return header.headerSize >= sizeof(header) && header.headerSize <= data.size()
+         && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header.vendorID == m_properties.vendorID
+         && header.deviceID == m_properties.deviceID
+         && memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "vulkan/vulkan_core.h"
+
+
+/*
+
+Pipeline cache shared by all pipelines, persisted on disk between runs
+* The file is a small header (device UUID, driver version) followed by the data of
+  vkGetPipelineCacheData. A file from another device or driver, or whose Vulkan header does not
+  match the device (vendor, device id, pipelineCacheUUID), is ignored and the cache starts empty.
+* The cache is internally synchronized: pipelines can be created from the loading thread.
+
+* Usage
+  - setup, with the device
+  - load, before creating any pipeline
+  - get, to pass to the pipeline creations
+  - save, on exit (destroy also saves)
+*/
+class PipelineCache
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice);
+  void destroy();
+  void load(const std::string& filename);
+  bool save();
+
+  VkPipelineCache get() const { return m_cache; }
+
+private:
+  bool readFile(std::vector<char>& data);
+  bool isCompatible(const std::vector<char>& data);
+
+  VkDevice                   m_device{VK_NULL_HANDLE};
+  VkPhysicalDeviceProperties m_properties{};
+  uint8_t                    m_deviceUUID[VK_UUID_SIZE]{};
+  std::string                m_filename;
+  VkPipelineCache            m_cache{VK_NULL_HANDLE};
+};
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Compacting the pixels selected by the foveation, such that the ray tracing
+ *  is only launched on the pixels actually traced this frame.
+ */
+
+
+#include <algorithm>
+
+#include "gpu_profiler.hpp"
+#include "nvvk/shaders_vk.hpp"
+#include "pixel_select.hpp"
+#include "tools.hpp"
+
+// Shaders
+#include "autogen/pixel_select.comp.h"
+
+
+//--------------------------------------------------------------------------------------------------
+// The selection is recorded in the command buffer of the trace: the family is the one of the
+// renderer, no command buffer is created here
+//
+void PixelSelect::setup(const VkDevice& device, const VkPhysicalDevice& /*physicalDevice*/, uint32_t /*familyIndex*/, nvvk::ResourceAllocator* allocator)
+{
+  m_device = device;
+  m_pAlloc = allocator;
+  m_debug.setup(device);
+}
+
+void PixelSelect::destroy()
+{
+  destroyPipeline();
+
+  if(m_readbackData != nullptr)
+    m_pAlloc->unmap(m_readback);
+  m_pAlloc->destroy(m_readback);
+  m_readbackData = nullptr;
+  m_readbackTrace.fill(0);
+}
+
+void PixelSelect::destroyPipeline()
+{
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+  m_pipelineLayout = VkPipelineLayout();
+  m_pipeline       = VkPipeline();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The layout is the same as the renderer, only the output set (S_OUT) is used by the shader
+//
+void PixelSelect::create(const std::vector<VkDescriptorSetLayout>& descSetLayouts)
+{
+  destroyPipeline();
+
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState)};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges    = &pushConstant;
+  pipelineLayoutCreateInfo.setLayoutCount         = static_cast<uint32_t>(descSetLayouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts            = descSetLayouts.data();
+  vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
+
+  VkComputePipelineCreateInfo computePipelineCreateInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+  computePipelineCreateInfo.layout       = m_pipelineLayout;
+  computePipelineCreateInfo.stage        = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  computePipelineCreateInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+  computePipelineCreateInfo.stage.module = nvvk::createShaderModule(m_device, pixel_select_comp, sizeof(pixel_select_comp));
+  computePipelineCreateInfo.stage.pName  = "main";
+
+  vkCreateComputePipelines(m_device, m_pipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_pipeline);
+  m_debug.setObjectName(m_pipeline, "PixelSelect");
+
+  vkDestroyShaderModule(m_device, computePipelineCreateInfo.stage.module, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Host visible copies of the indirect arguments, of the trace in flight and of the last completed one
+//
+void PixelSelect::createReadback()
+{
+  if(m_readbackData != nullptr)
+    m_pAlloc->unmap(m_readback);
+  m_pAlloc->destroy(m_readback);
+
+  m_readback = m_pAlloc->createBuffer(ReadbackSlots * sizeof(TraceRaysIndirectCmd), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                          | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  NAME_VK(m_readback.buffer);
+  m_readbackData = static_cast<TraceRaysIndirectCmd*>(m_pAlloc->map(m_readback));
+  m_readbackTrace.fill(0);
+}
+
+void PixelSelect::resetReadback()
+{
+  m_readbackTrace.fill(0);
+  m_activePixels = ~0u;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Counts copied by the trace, which must be completed (AsyncCompute timeline value). Null if the
+// trace did not copy them, or if the slot was taken by a later trace.
+//
+const TraceRaysIndirectCmd* PixelSelect::getReadback(uint64_t trace) const
+{
+  uint32_t slot = static_cast<uint32_t>(trace % ReadbackSlots);
+  if(trace == 0 || m_readbackData == nullptr || m_readbackTrace[slot] != trace)
+    return nullptr;
+  return &m_readbackData[slot];
+}
+
+//--------------------------------------------------------------------------------------------------
+// Return true if no pixel needed more samples after the completed trace
+//
+bool PixelSelect::hasConverged(uint64_t trace)
+{
+  const TraceRaysIndirectCmd* counts = getReadback(trace);
+  if(counts == nullptr)
+    return false;
+
+  m_activePixels = counts->nbActive;
+  return m_activePixels == 0;
+}
+
+uint32_t PixelSelect::getSelectedPixels(uint64_t trace) const
+{
+  const TraceRaysIndirectCmd* counts = getReadback(trace);
+  return counts != nullptr ? counts->width : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Reset the pixel count, fill the list and make it visible to the indirect ray trace.
+// The counts are copied to the readback slot of the trace, no copy for trace 0.
+// The tiles of the tiled trace (RtxState::tileSize) keep adding to the active count.
+//
+void PixelSelect::run(const VkCommandBuffer&              cmdBuf,
+                      const VkExtent2D&                   size,
+                      const std::vector<VkDescriptorSet>& descSets,
+                      VkBuffer                            traceCmd,
+                      uint64_t                            trace,
+                      bool                                resetActive)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  // The previous frame must be done reading the arguments and writing the image
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  // Empty list: width (count) = 0, height = depth = 1, no active pixel, no workgroup
+  TraceRaysIndirectCmd resetCmd{0, 1, 1, 0, 0, 1, 1};
+  if(resetActive)
+  {
+    vkCmdUpdateBuffer(cmdBuf, traceCmd, 0, sizeof(TraceRaysIndirectCmd), &resetCmd);
+  }
+  else
+  {
+    vkCmdUpdateBuffer(cmdBuf, traceCmd, 0, offsetof(TraceRaysIndirectCmd, nbActive), &resetCmd);
+    vkCmdUpdateBuffer(cmdBuf, traceCmd, offsetof(TraceRaysIndirectCmd, dispatchX),
+                      sizeof(TraceRaysIndirectCmd) - offsetof(TraceRaysIndirectCmd, dispatchX), &resetCmd.dispatchX);
+  }
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  // Selecting the pixels
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0,
+                          static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState), &m_state);
+  VkExtent2D area = size;
+  if(m_state.tileSize > 0)
+    area = {static_cast<uint32_t>(m_state.tileSize), static_cast<uint32_t>(m_state.tileSize)};
+  vkCmdDispatch(cmdBuf, (area.width + (SelectBlockSize - 1)) / SelectBlockSize,
+                (area.height + (SelectBlockSize - 1)) / SelectBlockSize, 1);
+
+  // The count is read as the launch size, the list and image by the renderer (ray generation or compute)
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+                     | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR
+                           | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  // Counts for the host, read once the trace is completed
+  if(trace != 0 && m_readbackData != nullptr)
+  {
+    uint32_t     slot = static_cast<uint32_t>(trace % ReadbackSlots);
+    VkBufferCopy region{0, slot * sizeof(TraceRaysIndirectCmd), sizeof(TraceRaysIndirectCmd)};
+    vkCmdCopyBuffer(cmdBuf, traceCmd, m_readback.buffer, 1, &region);
+
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+    m_readbackTrace[slot] = trace;
+  }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <array>
+
+#include "nvvk/resourceallocator_vk.hpp"
+#include "nvvk/debug_util_vk.hpp"
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Pixel selection pre-pass of the foveated ray tracing and adaptive sampling
+* Evaluates the eccentricity model (shaders/foveation.glsl) and the per-pixel convergence
+  (shaders/adaptive_sampling.glsl) over the render region and writes the compacted list of
+  pixels to trace, plus the arguments of the indirect launch.
+  Both buffers are owned by RenderOutput (S_OUT set).
+* The number of pixels not converged is copied to a host visible buffer, keyed by the trace
+  submission (AsyncCompute timeline value). It is read once that trace is completed, so the GPU
+  never stalls. One trace is in flight at a time: two slots, the one being written and the one
+  of the last completed trace.
+
+* Usage
+  - setup as usual
+  - create, with the same descriptor set layouts as the renderer
+  - createReadback
+  - run, before the renderer, with the address of the indirect arguments and the trace being
+    recorded. With the tiled trace, before each tile: the active count is kept over the tiles of
+    a pass, and copied for the host with the last one.
+  - hasConverged and getSelectedPixels, with the last completed trace
+*/
+class PixelSelect
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator);
+  void destroy();
+  void create(const std::vector<VkDescriptorSetLayout>& descSetLayouts);
+  void createReadback();
+  void run(const VkCommandBuffer&              cmdBuf,
+           const VkExtent2D&                   size,
+           const std::vector<VkDescriptorSet>& descSets,
+           VkBuffer                            traceCmd,
+           uint64_t                            trace,
+           bool                                resetActive = true);
+  void setPushContants(const RtxState& state) { m_state = state; }
+  void setPipelineCache(VkPipelineCache cache) { m_pipelineCache = cache; }
+
+  void     resetReadback();               // The traces in flight are from before a reset
+  bool     hasConverged(uint64_t trace);  // The completed trace left no active pixel
+  uint32_t getActivePixels() const { return m_activePixels; }
+  uint32_t getSelectedPixels(uint64_t trace) const;  // Traced by the completed trace, 0 if it did not select
+
+private:
+  void                        destroyPipeline();
+  const TraceRaysIndirectCmd* getReadback(uint64_t trace) const;
+
+  RtxState m_state{};
+
+  // Readback of TraceRaysIndirectCmd, slot `trace % 2`, with the trace which recorded the copy (0: none)
+  static constexpr uint32_t           ReadbackSlots = 2;
+  nvvk::Buffer                        m_readback;
+  TraceRaysIndirectCmd*               m_readbackData{nullptr};
+  std::array<uint64_t, ReadbackSlots> m_readbackTrace{};
+  uint32_t                            m_activePixels{~0u};  // Unknown until the first readback
+
+  // Setup
+  nvvk::ResourceAllocator* m_pAlloc{nullptr};  // Allocator of the readback
+  nvvk::DebugUtil          m_debug;            // Utility to name objects
+  VkDevice                 m_device{VK_NULL_HANDLE};
+  VkPipelineCache          m_pipelineCache{VK_NULL_HANDLE};
+
+  VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+  VkPipeline       m_pipeline{VK_NULL_HANDLE};
+};
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Implement the compute renderer, tracing with ray queries
+ */
+
+
+#include <cstddef>
+
+#include "gpu_profiler.hpp"
+#include "nvvk/shaders_vk.hpp"
+#include "ray_query.hpp"
+#include "scene.hpp"
+#include "tools.hpp"
+
+// Shaders
+#include "autogen/pathtrace.comp.h"
+
+//--------------------------------------------------------------------------------------------------
+//
+//
+void RayQuery::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t /*familyIndex*/, nvvk::ResourceAllocator* allocator)
+{
+  m_device = device;
+  m_pAlloc = allocator;
+  m_debug.setup(device);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Destroy all allocated resources
+//
+void RayQuery::destroy()
+{
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+  m_pipelineLayout = VkPipelineLayout();
+  m_pipeline       = VkPipeline();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Creation of the pipeline and layout
+// The incoming descriptors are: acceleration structure, offscreen image, scene data, hdr
+//
+void RayQuery::create(const VkExtent2D& size, const std::vector<VkDescriptorSetLayout>& descSetLayouts, Scene* scene)
+{
+  MilliTimer timer;
+  LOGI("Create Ray Query Pipeline");
+
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState)};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges    = &pushConstant;
+  pipelineLayoutCreateInfo.setLayoutCount         = static_cast<uint32_t>(descSetLayouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts            = descSetLayouts.data();
+  vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
+
+  VkComputePipelineCreateInfo computePipelineCreateInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+  computePipelineCreateInfo.layout       = m_pipelineLayout;
+  computePipelineCreateInfo.stage        = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  computePipelineCreateInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+  computePipelineCreateInfo.stage.module = nvvk::createShaderModule(m_device, pathtrace_comp, sizeof(pathtrace_comp));
+  computePipelineCreateInfo.stage.pName  = "main";
+
+  vkCreateComputePipelines(m_device, m_pipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_pipeline);
+  m_debug.setObjectName(m_pipeline, "RayQuery");
+
+  vkDestroyShaderModule(m_device, computePipelineCreateInfo.stage.module, nullptr);
+  timer.print();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Ray tracing the scene
+//
+void RayQuery::run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0,
+                          static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState), &m_state);
+
+  if(LAUNCH_OVER_PIXEL_LIST(m_state))
+  {
+    // Only the pixels compacted by the selection pass, the workgroup count is written by that pass
+    vkCmdDispatchIndirect(cmdBuf, m_indirectBuffer, offsetof(TraceRaysIndirectCmd, dispatchX));
+  }
+  else
+  {
+    vkCmdDispatch(cmdBuf, (size.width + (RayQueryTileSize - 1)) / RayQueryTileSize,
+                  (size.height + (RayQueryTileSize - 1)) / RayQueryTileSize, 1);
+  }
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Ray counters of the traces, read back without waiting for the GPU
+ */
+
+
+#include <algorithm>
+
+#include "ray_stats.hpp"
+#include "tools.hpp"
+
+
+void RayStats::setup(const VkDevice& device, nvvk::ResourceAllocator* allocator)
+{
+  m_device = device;
+  m_pAlloc = allocator;
+  m_debug.setup(device);
+}
+
+void RayStats::create()
+{
+  m_counters = m_pAlloc->createBuffer(sizeof(RayCounters),
+                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_counters.buffer);
+
+  m_readback = m_pAlloc->createBuffer(sizeof(RayCounters), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                          | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+  NAME_VK(m_readback.buffer);
+  m_readbackData = static_cast<RayCounters*>(m_pAlloc->map(m_readback));
+  m_pending      = false;
+}
+
+void RayStats::destroy()
+{
+  if(m_readbackData != nullptr)
+    m_pAlloc->unmap(m_readback);
+  m_pAlloc->destroy(m_readback);
+  m_pAlloc->destroy(m_counters);
+  m_readbackData = nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Clearing the counters before the trace, all its passes count in them
+//
+void RayStats::begin(const VkCommandBuffer& cmdBuf)
+{
+  vkCmdFillBuffer(cmdBuf, m_counters.buffer, 0, VK_WHOLE_SIZE, 0);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0, 1, &mb,
+                       0, nullptr, 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Copy for the host, read by update once the trace is done
+//
+void RayStats::end(const VkCommandBuffer& cmdBuf)
+{
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkBufferCopy region{0, 0, sizeof(RayCounters)};
+  vkCmdCopyBuffer(cmdBuf, m_counters.buffer, m_readback.buffer, 1, &region);
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+  m_pending = true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The trace is completed: its counters are in the readback buffer
+//
+bool RayStats::update(float traceMs)
+{
+  if(!m_pending || m_readbackData == nullptr)
+    return false;
+  m_pending = false;
+  m_last    = *m_readbackData;
+  m_traces++;
+
+  double raysPerSecond = traceMs > 0.f ? double(getLastRays()) / (traceMs * 1e-3) : 0.0;
+  float  skipRatio = m_last.candidates > 0 ? 1.f - std::min(float(m_last.pixels) / float(m_last.candidates), 1.f) : 0.f;
+  m_raysPerSecond  = m_traces > 1 ? m_raysPerSecond * 0.8 + raysPerSecond * 0.2 : raysPerSecond;
+  m_skipRatio      = m_traces > 1 ? m_skipRatio * 0.8f + skipRatio * 0.2f : skipRatio;
+
+  m_history[m_historyOffset] = float(raysPerSecond * 1e-6);
+  m_historyOffset            = (m_historyOffset + 1) % static_cast<int>(m_history.size());
+
+  writeTelemetry(traceMs, raysPerSecond, skipRatio);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+// CSV, one line per measured trace
+//
+bool RayStats::openTelemetry(const std::string& filename)
+{
+  m_telemetry.open(filename, std::ios::trunc);
+  if(!m_telemetry.is_open())
+  {
+    LOGE("Cannot open the ray telemetry: %s\n", filename.c_str());
+    return false;
+  }
+  m_telemetry << "trace,timeMs,primary,extension,shadow,anyHit,pixels,candidates,raysPerSecond,skipRatio\n";
+  return true;
+}
+
+void RayStats::writeTelemetry(float traceMs, double raysPerSecond, float skipRatio)
+{
+  if(!m_telemetry.is_open())
+    return;
+  m_telemetry << m_traces << ',' << traceMs << ',' << m_last.primary << ',' << m_last.extension << ',' << m_last.shadow
+              << ',' << m_last.anyHit << ',' << m_last.pixels << ',' << m_last.candidates << ',' << raysPerSecond << ','
+              << skipRatio << '\n';
+}
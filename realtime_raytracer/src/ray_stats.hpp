@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "nvvk/debug_util_vk.hpp"
+#include "nvvk/resourceallocator_vk.hpp"
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Ray counters of the traces: rays per kind, any hit invocations and pixels
+* The shaders count what they trace (RayCounters, shaders/ray_counters.glsl), with one atomic
+  per subgroup and counter. The pixel selection counts the pixels it considered: the ones not
+  traced were skipped by the foveation or the convergence.
+* The counters are cleared at the start of each trace and copied to a host visible buffer at
+  its end. They are read once the trace is seen completed (AsyncCompute), so the GPU never
+  stalls and the host never waits.
+* Rays per second are over the GPU time of the trace (primary, extension and shadow rays).
+  Telemetry: the averages and a ring buffer for the GUI and, if opened, a CSV file with the
+  counters of each trace.
+
+* Usage
+  - setup, create; destroy
+  - getBuffer: bound to the environment set (EnvBindings::eRayCounters)
+  - begin and end in the command buffer of the trace, around all the tracing
+  - update, with the GPU time of each completed trace which did work
+*/
+class RayStats
+{
+public:
+  void     setup(const VkDevice& device, nvvk::ResourceAllocator* allocator);
+  void     create();
+  void     destroy();
+  VkBuffer getBuffer() const { return m_counters.buffer; }
+
+  void begin(const VkCommandBuffer& cmdBuf);
+  void end(const VkCommandBuffer& cmdBuf);
+  bool update(float traceMs);
+  bool openTelemetry(const std::string& filename);
+
+  const RayCounters& getLast() const { return m_last; }  // Counters of the last completed trace
+  uint32_t           getTraces() const { return m_traces; }  // Traces read so far
+  uint64_t           getLastRays() const { return uint64_t(m_last.primary) + m_last.extension + m_last.shadow; }
+  double             getRaysPerSecond() const { return m_raysPerSecond; }  // Averaged
+  float              getSkipRatio() const { return m_skipRatio; }          // Averaged, pixels considered and not traced
+
+  const std::vector<float>& getHistory() const { return m_history; }  // Mrays/s, cycling
+  int                       getHistoryOffset() const { return m_historyOffset; }
+
+private:
+  void writeTelemetry(float traceMs, double raysPerSecond, float skipRatio);
+
+  nvvk::Buffer m_counters;  // Written by the shaders
+  nvvk::Buffer m_readback;  // Copy of the last trace
+  RayCounters* m_readbackData{nullptr};
+  bool         m_pending{false};  // A copy was recorded since the last update
+
+  RayCounters        m_last{};
+  double             m_raysPerSecond{0};
+  float              m_skipRatio{0};
+  uint32_t           m_traces{0};
+  std::vector<float> m_history = std::vector<float>(128, 0.f);
+  int                m_historyOffset{0};
+  std::ofstream      m_telemetry;
+
+  nvvk::ResourceAllocator* m_pAlloc{nullptr};
+  nvvk::DebugUtil          m_debug;
+  VkDevice                 m_device{VK_NULL_HANDLE};
+};
@@ -6,12 +6,16 @@
 #define VMA_IMPLEMENTATION
 
 #include "shaders/host_device.h"
+#include "gpu_profiler.hpp"
 #include "rtx_pipeline.hpp"
+#include "ray_query.hpp"
+#include "wavefront.hpp"
 #include "raytracer.hpp"
 #include "gui.hpp"
 #include "tools.hpp"
 
 #include "nvml_monitor.hpp"
+#include "nvp/nvpsystem.hpp"
 #include "fileformats/tiny_gltf_freeimage.h"
 
 
@@ -42,16 +46,41 @@ void Raytracer::setup(const VkInstance&               instance,
   // command requires graphic queue and not only transfer.
   m_scene.setup(m_device, physicalDevice, queues[eGCT1], &m_alloc);
 
-  // Transfer queues can be use for the creation of the following assets
-  m_offscreen.setup(m_device, physicalDevice, queues[eTransfer].familyIndex, &m_alloc);
+  // Compiled pipelines of the previous runs, saved on exit
+  m_pipelineCache.setup(m_device, physicalDevice);
+  m_pipelineCache.load(NVPSystem::exePath() + "pipeline_cache.bin");
+
+  // The output images are written by the trace on the compute queue, resolved and displayed on the graphics queue
+  m_offscreen.setup(m_device, physicalDevice, queues[eCompute].familyIndex, &m_alloc);
+  m_offscreen.setDisplayFamily(queues[eGCT0].familyIndex);
+  m_offscreen.setPipelineCache(m_pipelineCache.get());
+
+  // The pixel selection and the periphery reconstruction are pure compute passes, recorded with the trace
+  m_pixelSelect.setup(m_device, physicalDevice, queues[eCompute].familyIndex, &m_alloc);
+  m_peripheryBlur.setup(m_device, physicalDevice, queues[eCompute].familyIndex, &m_alloc);
+  m_reprojection.setup(m_device, physicalDevice, queues[eCompute].familyIndex, &m_alloc);
+  m_pixelSelect.setPipelineCache(m_pipelineCache.get());
+  m_peripheryBlur.setPipelineCache(m_pipelineCache.get());
+  m_reprojection.setPipelineCache(m_pipelineCache.get());
+
+  // The path tracing is submitted on the compute queue, the graphics queue only displays
+  m_asyncCompute.setup(m_device, physicalDevice, queues[eCompute]);
+  m_rayStats.setup(m_device, &m_alloc);
+  m_heatmap.setup(m_device, &m_alloc);
+
+  // GPU timings of the labelled scopes, on all queues
+  GpuProfiler::get().setup(m_device, physicalDevice);
 
   m_skydome.setup(device, physicalDevice, queues[eTransfer].familyIndex, &m_alloc);
 
   // Create and setup renderer
   m_pRender[eRtxPipeline] = new RtxPipeline;
+  m_pRender[eRayQuery]    = new RayQuery;
+  m_pRender[eWavefront]   = new Wavefront;
   for(auto r : m_pRender)
   {
-    r->setup(m_device, physicalDevice, queues[eTransfer].familyIndex, &m_alloc);
+    r->setup(m_device, physicalDevice, queues[eCompute].familyIndex, &m_alloc);  // Recorded with the trace
+    r->setPipelineCache(m_pipelineCache.get());
   }
 }
 
@@ -67,6 +96,7 @@ void Raytracer::loadScene(const std::string& filename)
 
   // The picker is the helper to return information from a ray hit under the mouse cursor
   m_picker.setTlas(m_accelStruct.getTlas());
+  m_heatmap.reset();  // Costs of the materials of the previous scene
   resetFrame();
 }
 
@@ -110,14 +140,7 @@ void Raytracer::loadAssets(const char* filename)
       // Loading scene and creating acceleration structure
       loadScene(sfile);
 
-      // Loading the scene might have loaded new textures, which is changing the number of elements
-      // in the DescriptorSetLayout. Therefore, the PipelineLayout will be out-of-date and need
-      // to be re-created. If they are re-created, the pipeline also need to be re-created.
-      for(auto& r : m_pRender)
-        r->destroy();
-
-      m_pRender[m_rndMethod]->create(
-          m_size, {m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout}, &m_scene);
+      recreateRender();
     }
 
     if(extension == ".hdr")  //|| extension == ".exr")
@@ -144,10 +167,26 @@ void Raytracer::updateUniformBuffer(const VkCommandBuffer& cmdBuf)
     return;
 
   LABEL_SCOPE_VK(cmdBuf);
+
+  PROFILE_SCOPE_VK(cmdBuf);
   const float aspectRatio = m_renderRegion.extent.width / static_cast<float>(m_renderRegion.extent.height);
 
   m_scene.updateCamera(cmdBuf, aspectRatio);
   vkCmdUpdateBuffer(cmdBuf, m_sunAndSkyBuffer.buffer, 0, sizeof(SunAndSky), &m_sunAndSky);
+
+  // Foveation profile, only when another one was selected
+  if(m_foveation.isDirty())
+  {
+    const auto& lut = m_foveation.getLut();
+    vkCmdUpdateBuffer(cmdBuf, m_foveaLutBuffer.buffer, 0, sizeof(lut), lut.data());
+    m_foveation.clearDirty();
+
+    VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                         0, 1, &mb, 0, nullptr, 0, nullptr);
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -155,20 +194,54 @@ void Raytracer::updateUniformBuffer(const VkCommandBuffer& cmdBuf)
 //
 void Raytracer::updateFrame()
 {
-  static nvmath::mat4f refCamMatrix;
-  static float         fov = 0;
+  // Camera path playback: the camera and gaze of this frame, compared below as any camera move
+  nvmath::vec2f pathGaze;
+  bool          playing = m_cameraPath.playFrame(pathGaze, m_rtxState.frameSeed);
+  if(!playing)
+    m_rtxState.frameSeed = 0;
 
   auto& m = CameraManip.getMatrix();
   auto  f = CameraManip.getFov();
-  if(memcmp(&refCamMatrix.a00, &m.a00, sizeof(nvmath::mat4f)) != 0 || f != fov)
+  if(hasCameraChanged())
   {
-    resetFrame();
-    refCamMatrix = m;
-    fov          = f;
+    // With reprojection, the accumulation follows the camera and the frame counter keeps running,
+    // so random sequences and foveation intervals keep changing while the camera never stops
+    if(m_rtxState.enableReprojection == 1 && m_rtxState.frame > 0)
+    {
+      m_reprojectHistory = true;
+      m_pixelSelect.resetReadback();
+      if(m_rtxState.frame >= m_maxFrames)
+        m_rtxState.frame = 0;  // Resuming the rendering, without clearing
+    }
+    else
+    {
+      resetFrame();
+    }
+    m_refCamMatrix = m;
+    m_refFov       = f;
   }
 
   if(m_rtxState.frame < m_maxFrames)
     m_rtxState.frame++;
+
+  // Moving the fovea does not invalidate the accumulation, only where samples go
+  m_gaze.update();
+  m_rtxState.gazePosition = playing ? pathGaze : m_gaze.getPosition();
+  m_cameraPath.recordFrame(m_rtxState.gazePosition);
+
+  // Foveation profiles are in degrees of visual angle: through the camera, following its field of
+  // view, unless the geometry of the display seen by the viewer is given (-displayPitch)
+  if(m_displayPixelPitchMm > 0.f && m_viewDistanceMm > 0.f)
+    m_rtxState.tanHalfFovY = 0.5f * m_renderRegion.extent.height * m_displayPixelPitchMm / m_viewDistanceMm;
+  else
+    m_rtxState.tanHalfFovY = tanf(nv_to_rad * f * 0.5f);
+  m_rtxState.foveaLutRange = m_foveation.getRange();
+}
+
+bool Raytracer::hasCameraChanged() const
+{
+  auto& m = CameraManip.getMatrix();
+  return memcmp(&m_refCamMatrix.a00, &m.a00, sizeof(nvmath::mat4f)) != 0 || CameraManip.getFov() != m_refFov;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -179,6 +252,8 @@ void Raytracer::resetFrame()
     //Since resetFrame will be called before updateFrame increments the frame counter, 
     //resetFrame will set the frame counter to -1:
   m_rtxState.frame = -1;
+  m_reprojectHistory = false;
+  m_pixelSelect.resetReadback();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -193,6 +268,9 @@ void Raytracer::createDescriptorSetLayout()
   m_bind.addBinding({EnvBindings::eSunSky, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_MISS_BIT_KHR | flags});
   m_bind.addBinding({EnvBindings::eHdr, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, flags});  // HDR image
   m_bind.addBinding({EnvBindings::eImpSamples, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, flags});   // importance sampling
+  m_bind.addBinding({EnvBindings::eFoveaLut, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, flags});    // foveation profile
+  m_bind.addBinding({EnvBindings::eRayCounters, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, flags});  // ray counters
+  m_bind.addBinding({EnvBindings::eHeatmapStats, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, flags});  // heatmap material costs
 
 
   m_descPool = m_bind.createPool(m_device, 1);
@@ -203,9 +281,15 @@ void Raytracer::createDescriptorSetLayout()
   std::vector<VkWriteDescriptorSet> writes;
   VkDescriptorBufferInfo            sunskyDesc{m_sunAndSkyBuffer.buffer, 0, VK_WHOLE_SIZE};
   VkDescriptorBufferInfo            accelImpSmpl{m_skydome.m_accelImpSmpl.buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo            foveaLutDesc{m_foveaLutBuffer.buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo            rayCountersDesc{m_rayStats.getBuffer(), 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo            heatmapDesc{m_heatmap.getBuffer(), 0, VK_WHOLE_SIZE};
   writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eSunSky, &sunskyDesc));
   writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eHdr, &m_skydome.m_texHdr.descriptor));
   writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eImpSamples, &accelImpSmpl));
+  writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eFoveaLut, &foveaLutDesc));
+  writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eRayCounters, &rayCountersDesc));
+  writes.emplace_back(m_bind.makeWrite(m_descSet, EnvBindings::eHeatmapStats, &heatmapDesc));
 
   vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
@@ -232,6 +316,14 @@ void Raytracer::createUniformBuffer()
   m_sunAndSkyBuffer = m_alloc.createBuffer(sizeof(SunAndSky), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
   NAME_VK(m_sunAndSkyBuffer.buffer);
+
+  m_foveaLutBuffer = m_alloc.createBuffer(sizeof(FoveaLutEntry) * FoveaLutSize,
+                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_foveaLutBuffer.buffer);
+
+  m_rayStats.create();
+  m_heatmap.create();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -241,6 +333,9 @@ void Raytracer::destroyResources()
 {
   // Resources
   m_alloc.destroy(m_sunAndSkyBuffer);
+  m_alloc.destroy(m_foveaLutBuffer);
+  m_rayStats.destroy();
+  m_heatmap.destroy();
 
   // Descriptors
   vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
@@ -251,8 +346,14 @@ void Raytracer::destroyResources()
   m_scene.destroy();
   m_accelStruct.destroy();
   m_offscreen.destroy();
+  m_pixelSelect.destroy();
+  m_peripheryBlur.destroy();
+  m_reprojection.destroy();
   m_skydome.destroy();
   m_axis.deinit();
+  m_asyncCompute.destroy();
+  m_tiles.destroy();
+  GpuProfiler::get().destroy();
 
   // All renderers
   for(auto p : m_pRender)
@@ -261,6 +362,9 @@ void Raytracer::destroyResources()
     p = nullptr;
   }
 
+  // Last, once the background compilations of the renderers are done with it
+  m_pipelineCache.destroy();  // Saving it
+
   // Memory
   m_alloc.deinit();
 }
@@ -271,6 +375,8 @@ void Raytracer::destroyResources()
 void Raytracer::onResize(int /*w*/, int /*h*/)
 {
   m_offscreen.update(m_size);
+  if(m_rndMethod != eNone)
+    m_pRender[m_rndMethod]->update(m_size);
   resetFrame();
 }
 
@@ -366,7 +472,7 @@ ImGui_ImplVulkan_InitInfo Raytracer::createImGuiInitInfo()
     init_info.Device = m_device; 
     init_info.QueueFamily = m_graphicsQueueIndex; 
     init_info.Queue = m_queue;
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = m_pipelineCache.get();
     init_info.DescriptorPool = m_imguiDescPool;
     init_info.Subpass = 0;
     init_info.MinImageCount = 2;
@@ -417,6 +523,26 @@ void Raytracer::createRender(RndMethod method)
 
   m_pRender[m_rndMethod]->create(
       m_size, {m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout}, &m_scene);
+  m_pixelSelect.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
+  m_peripheryBlur.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
+  m_reprojection.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
+}
+
+//--------------------------------------------------------------------------------------------------
+// Loading the scene might have loaded new textures, which is changing the number of elements
+// in the DescriptorSetLayout. Therefore, the PipelineLayout will be out-of-date and need
+// to be re-created. If they are re-created, the pipeline also need to be re-created.
+//
+void Raytracer::recreateRender()
+{
+  for(auto& r : m_pRender)
+    r->destroy();
+
+  m_pRender[m_rndMethod]->create(
+      m_size, {m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout}, &m_scene);
+  m_pixelSelect.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
+  m_peripheryBlur.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
+  m_reprojection.create({m_accelStruct.getDescLayout(), m_offscreen.getDescLayout(), m_scene.getDescLayout(), m_descSetLayout});
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -436,15 +562,70 @@ void Raytracer::setRenderRegion(const VkRect2D& size)
 void Raytracer::createOffscreenRender()
 {
   m_offscreen.create(m_size, m_renderPass);
+  m_pixelSelect.createReadback();
   m_axis.init(m_device, m_renderPass, 0, 50.0f);
 }
 
+//--------------------------------------------------------------------------------------------------
+// Before the render pass: the displayed image is the latest completed trace. When a new one is
+// done, it is copied to the displayed image and its mipmaps are generated, the blit needs the
+// graphics queue. Otherwise the display keeps showing the previous one.
+//
+void Raytracer::preparePost(const VkCommandBuffer& cmdBuf)
+{
+  if(!m_asyncCompute.acquireResult())
+    return;
+
+  // Dynamic resolution: the display stretches the traced extent over the region, and the next
+  // trace follows the measured time of this one, as does the foveation budget. The ray counters
+  // and heatmap costs of the trace are read back.
+  if(!m_traceIdle)
+  {
+    auto& tm   = m_offscreen.m_tonemapper;
+    tm.uvScale = {float(m_traceSize.width) / float(m_renderRegion.extent.width),
+                  float(m_traceSize.height) / float(m_renderRegion.extent.height)};
+    tm.uvMax   = {(float(m_traceSize.width) - 0.5f) / float(m_size.width), (float(m_traceSize.height) - 0.5f) / float(m_size.height)};
+
+    // One controller at a time owns the time of a frame, the whole pass for the tiled trace. The
+    // foveation budget reduces first, the resolution only once the foveation is at its most
+    // reduced, against the same budget, and it comes back first.
+    m_passTime += m_asyncCompute.getTraceTime();
+    if(m_traceEndsPass)
+    {
+      float frameMs   = m_passTime;
+      bool  foveaOwns = m_rtxState.enableFoveation == 1 && m_foveaBudget.m_enable;
+      m_passTime      = 0.f;
+      if(!foveaOwns || m_foveaBudget.getLevel() >= 1.f || m_dynResolution.getScale() < 1.f)
+      {
+        if(m_dynResolution.update(frameMs, foveaOwns ? m_foveaBudget.m_budgetMs : m_dynResolution.m_targetMs))
+          resetFrame();  // The accumulation is at the previous resolution
+      }
+      if(m_rtxState.enableFoveation == 1 && m_dynResolution.getScale() >= 1.f && m_foveaBudget.update(frameMs))
+        m_foveation.adjust(m_foveaBudget.getRadiusScale(), m_foveaBudget.getIntervalScale(), m_foveaBudget.m_minFoveaDeg);
+    }
+    if(m_rtxState.enableRayCounters == 1)
+      m_rayStats.update(m_asyncCompute.getTraceTime());
+    if(m_traceHeatmap && m_heatmap.update())
+      m_rtxState.heatmapScale = m_heatmap.getScale();
+  }
+  m_offscreen.m_tonemapper.heatmap = m_traceHeatmap ? 1 : 0;  // The image holds the cost colors
+
+  m_offscreen.resolve(cmdBuf);
+
+  // For automatic brightness tonemapping
+  if(m_offscreen.m_tonemapper.autoExposure)
+  {
+    m_offscreen.genMipmap(cmdBuf);
+  }
+}
+
 //--------------------------------------------------------------------------------------------------
 // This will draw the result of the rendering and apply the tonemapper.
 // If enabled, draw orientation axis in the lower left corner.
 void Raytracer::drawPost(VkCommandBuffer cmdBuf)
 {
   LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
   auto size = nvmath::vec2f(m_size.width, m_size.height);
   auto area = nvmath::vec2f(m_renderRegion.extent.width, m_renderRegion.extent.height);
 
@@ -462,10 +643,92 @@ void Raytracer::drawPost(VkCommandBuffer cmdBuf)
 
 }
 
+//--------------------------------------------------------------------------------------------------
+// Same as AppBaseVk::submitFrame. When resolving a trace, also waiting for it and signaling when
+// it is copied, for the next trace to start (AsyncCompute)
+//
+void Raytracer::submitFrame()
+{
+  uint32_t imageIndex = m_swapChain.getActiveImageIndex();
+  vkResetFences(m_device, 1, &m_waitFences[imageIndex]);
+
+  const VkCommandBuffer cmdBuf = getCommandBuffers()[getCurFrame()];
+
+  // The trace was seen completed on the host, the wait on the copy of the result does not stall
+  std::array<VkSemaphore, 2>          waitSemaphores{m_swapChain.getActiveReadSemaphore(), m_asyncCompute.getTraced()};
+  std::array<uint64_t, 2>             waitValues{0, m_asyncCompute.getResolveValue()};
+  std::array<VkPipelineStageFlags, 2> waitStages{VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT};
+  std::array<VkSemaphore, 2>          signalSemaphores{m_swapChain.getActiveWrittenSemaphore(), m_asyncCompute.getResolved()};
+  std::array<uint64_t, 2>             signalValues{0, m_asyncCompute.getResolveValue()};
+  uint32_t                            semaphoreCount = m_asyncCompute.hasResolve() ? 2 : 1;  // Only the swapchain
+
+  // Values are ignored for the binary semaphores of the swapchain
+  VkTimelineSemaphoreSubmitInfo timelineInfo{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.waitSemaphoreValueCount   = semaphoreCount;
+  timelineInfo.pWaitSemaphoreValues      = waitValues.data();
+  timelineInfo.signalSemaphoreValueCount = semaphoreCount;
+  timelineInfo.pSignalSemaphoreValues    = signalValues.data();
+
+  VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.pNext                = &timelineInfo;
+  submitInfo.waitSemaphoreCount   = semaphoreCount;
+  submitInfo.pWaitSemaphores      = waitSemaphores.data();
+  submitInfo.pWaitDstStageMask    = waitStages.data();
+  submitInfo.commandBufferCount   = 1;
+  submitInfo.pCommandBuffers      = &cmdBuf;
+  submitInfo.signalSemaphoreCount = semaphoreCount;
+  submitInfo.pSignalSemaphores    = signalSemaphores.data();
+
+  // Submit to the graphics queue, then presenting the frame
+  vkQueueSubmit(m_queue, 1, &submitInfo, m_waitFences[imageIndex]);
+  m_swapChain.present(m_queue);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Ray tracing
 //////////////////////////////////////////////////////////////////////////
 
+//--------------------------------------------------------------------------------------------------
+// Starting the next trace on the compute queue, once the previous one is resolved: the frame
+// update, the uniforms and the ray tracing. The trace runs at its own rate, over as many display
+// frames as it takes. Call after preparePost, which resolves the completed trace.
+// With the tiled trace, a frame is a pass over all tiles, which can take several traces: the
+// frame only advances once the pass is done, or restarts when the camera moves.
+//
+void Raytracer::traceFrame()
+{
+  if(m_busy)
+  {
+    m_gui->showBusyWindow();  // Busy while loading scene, which is using the compute queue
+    return;
+  }
+
+  if(!m_asyncCompute.canTrace())
+    return;  // Still tracing
+
+  if(!m_tiles.m_enable || m_tiles.isPassDone() || m_rtxState.frame < 0 || hasCameraChanged())
+  {
+    updateFrame();  // Increment/update rendering frame count, one per trace or pass of tiles
+    if(m_tiles.m_enable)
+      m_tiles.beginPass(m_dynResolution.getExtent(m_renderRegion.extent), m_rtxState.gazePosition);
+    m_passTime = 0.f;  // A restarted pass is not measured
+  }
+
+  VkCommandBuffer cmdBuf = m_asyncCompute.beginTrace();
+  m_traceIdle            = true;  // Until the ray tracing is recorded
+  m_traceHeatmap         = m_rtxState.heatmap == 1;
+  m_traceEndsPass        = true;  // Unless tiles of the pass are left
+  updateUniformBuffer(cmdBuf);    // Updating UBOs
+  m_rayStats.begin(cmdBuf);
+  if(m_traceHeatmap)
+    m_heatmap.begin(cmdBuf);
+  renderScene(cmdBuf);
+  m_rayStats.end(cmdBuf);
+  if(m_traceHeatmap)
+    m_heatmap.end(cmdBuf);
+  m_asyncCompute.submitTrace();
+}
+
 void Raytracer::renderScene(const VkCommandBuffer& cmdBuf)
 {
 
@@ -478,25 +741,92 @@ void Raytracer::renderScene(const VkCommandBuffer& cmdBuf)
 
   LABEL_SCOPE_VK(cmdBuf);
 
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  // Tiled trace: the frame is started by the first tiles of the pass, the others continue it
+  bool tiled     = m_tiles.m_enable;
+  bool passStart = !tiled || m_tiles.isPassStart();
 
   // We are done rendering
-  if(m_rtxState.frame >= m_maxFrames)
+  if(passStart && m_rtxState.frame >= m_maxFrames)
     return;
 
-  // Handling de-scaling by reducing the size to render
-  VkExtent2D render_size = m_renderRegion.extent;
+  // Adaptive sampling: all pixels were converged after the previous trace, completed (canTrace)
+  if(passStart && m_rtxState.enableAdaptiveSampling == 1 && m_pixelSelect.hasConverged(m_asyncCompute.getResolveValue()))
+    return;
+
+  // Handling de-scaling by reducing the size to render, and the dynamic resolution
+  VkExtent2D render_size = m_dynResolution.getExtent(m_renderRegion.extent);
+  m_traceSize            = render_size;
+  m_traceIdle            = false;
 
   m_rtxState.size = {render_size.width, render_size.height};
-  // State is the push constant structure
-  m_pRender[m_rndMethod]->setPushContants(m_rtxState);
-  // Running the renderer
-  m_pRender[m_rndMethod]->run(cmdBuf, render_size, {m_accelStruct.getDescSet(), m_offscreen.getDescSet(), m_scene.getDescSet(), m_descSet});
+  std::vector<VkDescriptorSet> descSets{m_accelStruct.getDescSet(), m_offscreen.getDescSet(), m_scene.getDescSet(), m_descSet};
 
+  // First frame after a reset, no samples are kept
+  if(passStart && m_rtxState.frame == 0)
+    m_offscreen.clearAccumulation(cmdBuf);
 
-  // For automatic brightness tonemapping
-  if(m_offscreen.m_tonemapper.autoExposure)
+  // The camera moved: the history is moved to where the surfaces are now, the trace validates it.
+  // The flag holds for all tiles of the pass.
+  if(passStart)
   {
-    m_offscreen.genMipmap(cmdBuf);
+    m_rtxState.historyReprojected = m_reprojectHistory ? 1 : 0;
+    if(m_reprojectHistory)
+    {
+      m_offscreen.copyHistory(cmdBuf);
+      m_reprojection.setPushContants(m_rtxState);
+      m_reprojection.run(cmdBuf, render_size, descSets);
+      m_reprojectHistory = false;
+    }
+  }
+
+  if(tiled)
+  {
+    // The tiles fitting in the budget, each one selected and traced over the pixel list.
+    // The active count of the pass is read back with its last tile.
+    uint32_t nbTiles = m_tiles.begin(m_asyncCompute.getTilesTime());
+    m_asyncCompute.beginTiles();
+    for(uint32_t i = 0; i < nbTiles; i++)
+    {
+      VkRect2D tile         = m_tiles.getTile(i);
+      bool     lastOfPass   = m_tiles.isPassDone() && i == nbTiles - 1;
+      m_rtxState.tileSize   = TraceTileSize;
+      m_rtxState.tileOrigin = {tile.offset.x, tile.offset.y};
+
+      m_pixelSelect.setPushContants(m_rtxState);
+      m_pixelSelect.run(cmdBuf, render_size, descSets, m_offscreen.getTraceCmd(), lastOfPass ? m_asyncCompute.getTraceValue() : 0,
+                        passStart && i == 0);
+
+      m_pRender[m_rndMethod]->setPushContants(m_rtxState);
+      m_pRender[m_rndMethod]->setIndirectArgs(m_offscreen.getTraceCmd(), m_offscreen.getTraceCmdAddress());
+      m_pRender[m_rndMethod]->run(cmdBuf, render_size, descSets);
+    }
+    m_asyncCompute.endTiles();
+    m_rtxState.tileSize = 0;
+    m_traceEndsPass     = m_tiles.isPassDone();
+  }
+  else
+  {
+    // Foveation and adaptive sampling: compacting the pixels to trace, the renderer is launched on that list only
+    if(m_rtxState.enableFoveation == 1 || m_rtxState.enableAdaptiveSampling == 1)
+    {
+      m_pixelSelect.setPushContants(m_rtxState);
+      m_pixelSelect.run(cmdBuf, render_size, descSets, m_offscreen.getTraceCmd(), m_asyncCompute.getTraceValue());
+    }
+
+    // State is the push constant structure
+    m_pRender[m_rndMethod]->setPushContants(m_rtxState);
+    m_pRender[m_rndMethod]->setIndirectArgs(m_offscreen.getTraceCmd(), m_offscreen.getTraceCmdAddress());
+    // Running the renderer
+    m_pRender[m_rndMethod]->run(cmdBuf, render_size, descSets);
+  }
+
+  // Reconstructing the periphery from the pixels traced so far, the heatmap only shows the traced ones
+  if(m_rtxState.enableFoveation == 1 && m_rtxState.enablePeripheryBlur == 1 && m_rtxState.heatmap == 0)
+  {
+    m_peripheryBlur.setPushContants(m_rtxState);
+    m_peripheryBlur.run(cmdBuf, render_size, descSets);
   }
 }
 
@@ -556,6 +886,13 @@ void Raytracer::onMouseMotion(int x, int y)
 
   if(ImGui::GetCurrentContext() != nullptr && ImGui::GetIO().WantCaptureKeyboard)
     return;
+
+  // Mouse gaze source: cursor position in the rendering region
+  if(m_renderRegion.extent.width > 0 && m_renderRegion.extent.height > 0)
+  {
+    m_gaze.setCursor({float(x - m_renderRegion.offset.x) / float(m_renderRegion.extent.width),
+                      float(y - m_renderRegion.offset.y) / float(m_renderRegion.extent.height)});
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
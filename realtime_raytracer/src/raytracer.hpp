@@ -19,14 +19,29 @@ typedef nvvk::ResourceAllocatorDma Allocator;
 #include "nvvk/raypicker_vk.hpp"
 
 #include "accelstruct.hpp"
+#include "async_compute.hpp"
+#include "camera_path.hpp"
+#include "dynamic_resolution.hpp"
+#include "foveation_budget.hpp"
+#include "foveation_profile.hpp"
+#include "gaze_input.hpp"
+#include "heatmap.hpp"
+#include "periphery_blur.hpp"
+#include "pipeline_cache.hpp"
+#include "pixel_select.hpp"
+#include "ray_stats.hpp"
 #include "render_output.hpp"
+#include "reprojection.hpp"
 #include "scene.hpp"
 #include "shaders/host_device.h"
+#include "tile_scheduler.hpp"
 
 #include "imgui_internal.h"
 #include "queue.hpp"
 
 class GUI;
+class Headless;
+class Benchmark;
 
 //--------------------------------------------------------------------------------------------------
 // Simple rasterizer of OBJ objects
@@ -38,11 +53,15 @@ class GUI;
 class Raytracer : public nvvkhl::AppBaseVk
 {
   friend GUI;
+  friend Headless;
+  friend Benchmark;
 
 public:
   enum RndMethod
   {
     eRtxPipeline,
+    eRayQuery,
+    eWavefront,
     eNone,
   };
 
@@ -75,15 +94,34 @@ public:
   void renderGui();
 
   void createRender(RndMethod method);
+  void recreateRender();
   void resetFrame();
   void updateFrame();
+  bool hasCameraChanged() const;
   void updateHdrDescriptors();
   void updateUniformBuffer(const VkCommandBuffer& cmdBuf);
 
   Scene              m_scene;
   AccelStructure     m_accelStruct;
   RenderOutput       m_offscreen;
+  PixelSelect        m_pixelSelect;
+  PeripheryBlur      m_peripheryBlur;
+  Reprojection       m_reprojection;
+  GazeInput          m_gaze;
+  CameraPath         m_cameraPath;
+  FoveationProfiles  m_foveation;
+  FoveationBudget    m_foveaBudget;
+  // Display seen by the viewer, to convert pixels to degrees of visual angle. Only with -displayPitch,
+  // by default (pitch 0) the visual angle is the one through the camera.
+  float              m_displayPixelPitchMm{0.f};  // Physical size of a pixel of the display
+  float              m_viewDistanceMm{600.f};     // From the eye to the display
   HdrSampling        m_skydome;
+  PipelineCache      m_pipelineCache;
+  AsyncCompute       m_asyncCompute;
+  TileScheduler      m_tiles;
+  DynamicResolution  m_dynResolution;
+  RayStats           m_rayStats;
+  Heatmap            m_heatmap;
   nvvk::AxisVK       m_axis;
   nvvk::RayPickerKHR m_picker;
 
@@ -92,6 +130,7 @@ public:
   RndMethod                    m_rndMethod{eNone};
 
   nvvk::Buffer m_sunAndSkyBuffer;
+  nvvk::Buffer m_foveaLutBuffer;
 
   // Graphic pipeline
   VkDescriptorPool            m_descPool{VK_NULL_HANDLE};
@@ -103,14 +142,22 @@ public:
   nvvk::DebugUtil m_debug;  // Utility to name objects
 
 
-  VkRect2D m_renderRegion{};
-  void     setRenderRegion(const VkRect2D& size);
+  VkRect2D   m_renderRegion{};
+  VkExtent2D m_traceSize{};  // Extent of the last trace which did work, a part of the region with dynamic resolution
+  bool       m_traceIdle{true};  // The trace in flight had nothing to do, no time to measure
+  bool       m_traceHeatmap{false};  // The trace in flight renders the heatmap debug view
+  bool       m_traceEndsPass{true};  // The trace in flight is the last of its pass of tiles, or not tiled
+  float      m_passTime{0.f};        // GPU time of the completed traces of the pass of tiles (ms)
+  void       setRenderRegion(const VkRect2D& size);
 
   // #Post
   void createOffscreenRender();
+  void preparePost(const VkCommandBuffer& cmdBuf);
   void drawPost(VkCommandBuffer cmdBuf);
+  void submitFrame();
 
   // #VKRay
+  void traceFrame();
   void renderScene(const VkCommandBuffer& cmdBuf);
 
 
@@ -124,6 +171,22 @@ public:
       {0, 0},  // size;
       0,       // enable Foveation
       0,       // Periphery bluring
+      {0.5f, 0.5f},    // gazePosition
+      0.577f,          // tanHalfFovY, set from the display or the camera
+      60.f,            // foveaLutRange, set from the profile
+      0,               // enableAdaptiveSampling
+      0.01f,           // convergenceThreshold
+      16,              // minPixelSamples
+      4,               // maxSampleBoost
+      1,               // enableReprojection
+      0,               // historyReprojected, set for each frame
+      256,             // maxHistorySamples
+      0,               // tileSize, set for each tile of the tiled trace
+      {0, 0},          // tileOrigin
+      0,               // frameSeed, set by the camera path playback
+      1,               // enableRayCounters
+      0,               // heatmap
+      0.f,             // heatmapScale, set from the measured costs
   };
 
   SunAndSky m_sunAndSky{
@@ -146,7 +209,11 @@ public:
   };
 
   int         m_maxFrames{10000};
+  bool        m_supportRayQuery{false};  // VK_KHR_ray_query is optional, the compute and wavefront renderers need it
+  bool        m_reprojectHistory{false};  // Camera moved, reprojecting the accumulation on the next render
   bool        m_busy{false};
+  nvmath::mat4f m_refCamMatrix;  // Camera of the current frame, a change restarts or reprojects it
+  float         m_refFov{0};
   std::string m_busyReasonText;
 
 
@@ -24,7 +24,11 @@
  */
 
 
+#include <cassert>
+
+#include "gpu_profiler.hpp"
 #include "nvh/fileoperations.hpp"
+#include "nvvk/buffers_vk.hpp"
 #include "nvvk/commands_vk.hpp"
 #include "nvvk/images_vk.hpp"
 #include "nvvk/pipeline_vk.hpp"
@@ -42,15 +46,49 @@ void RenderOutput::setup(const VkDevice& device, const VkPhysicalDevice& physica
   m_device     = device;
   m_pAlloc     = allocator;
   m_queueIndex = familyIndex;
+  m_families   = {familyIndex};
   m_debug.setup(device);
 
   m_offscreenDepthFormat = nvvk::findDepthFormat(physicalDevice);
 }
 
+//--------------------------------------------------------------------------------------------------
+// The images and buffers are written by the trace on the compute queue, and the result is resolved
+// and displayed on the graphics queue. From different families, they are created concurrent over
+// both, so no ownership transfer is needed between the two submissions. Call before create.
+//
+void RenderOutput::setDisplayFamily(uint32_t familyIndex)
+{
+  m_families = {m_queueIndex};
+  if(familyIndex != m_queueIndex)
+    m_families.push_back(familyIndex);
+}
+
+template <class CreateInfo>
+void RenderOutput::setSharing(CreateInfo& createInfo) const
+{
+  if(m_families.size() < 2)
+    return;
+  createInfo.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+  createInfo.queueFamilyIndexCount = static_cast<uint32_t>(m_families.size());
+  createInfo.pQueueFamilyIndices   = m_families.data();
+}
+
 
 void RenderOutput::destroy()
 {
   m_pAlloc->destroy(m_offscreenColor);
+  m_pAlloc->destroy(m_resultColor);
+  m_pAlloc->destroy(m_accumColor);
+  m_pAlloc->destroy(m_moments);
+  m_pAlloc->destroy(m_blurTemp);
+  m_pAlloc->destroy(m_firstHit);
+  m_pAlloc->destroy(m_histAccum);
+  m_pAlloc->destroy(m_histMoments);
+  m_pAlloc->destroy(m_histFirstHit);
+  m_pAlloc->destroy(m_heatmap);
+  m_pAlloc->destroy(m_pixelList);
+  m_pAlloc->destroy(m_traceCmd);
 
   vkDestroyPipeline(m_device, m_postPipeline, nullptr);
   vkDestroyPipelineLayout(m_device, m_postPipelineLayout, nullptr);
@@ -88,6 +126,7 @@ void RenderOutput::createOffscreenRender(const VkExtent2D& size)
     auto colorCreateInfo = nvvk::makeImage2DCreateInfo(
         size, m_offscreenColorFormat,
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT, true);
+    setSharing(colorCreateInfo);
 
     nvvk::Image image = m_pAlloc->createImage(colorCreateInfo);
     NAME_VK(image.image);
@@ -99,19 +138,92 @@ void RenderOutput::createOffscreenRender(const VkExtent2D& size)
     m_offscreenColor.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
   }
 
+  // Result of the ray tracing, copied to the color image once the display is done with it
+  createStorage(m_resultColor, size, m_offscreenColorFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+  // Accumulation, same format, no mipmaps: running sum (rgb) and sample count (a)
+  const VkImageUsageFlags historyUsage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  createStorage(m_accumColor, size, m_offscreenColorFormat, historyUsage);
+
+  // Intermediate of the separable periphery reconstruction: weighted sum (rgb) and weight (a)
+  createStorage(m_blurTemp, size, m_offscreenColorFormat, VK_IMAGE_USAGE_STORAGE_BIT);
+
+  // Luminance second moment of the accumulated samples, for the variance estimate
+  createStorage(m_moments, size, m_momentsFormat, historyUsage);
+
+  // First hit of the accumulated samples, and the previous frame copies for the reprojection
+  createStorage(m_firstHit, size, m_offscreenColorFormat, historyUsage);
+  createStorage(m_histAccum, size, m_offscreenColorFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+  createStorage(m_histMoments, size, m_momentsFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+  createStorage(m_histFirstHit, size, m_offscreenColorFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+  // Clock cost of the traced pixels, for the heatmap debug view
+  createStorage(m_heatmap, size, m_heatmapFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
   // Setting the image layout for both color and depth
   {
     nvvk::CommandPool genCmdBuf(m_device, m_queueIndex);
     auto              cmdBuf = genCmdBuf.createCommandBuffer();
     nvvk::cmdBarrierImageLayout(cmdBuf, m_offscreenColor.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    for(auto* texture : {&m_resultColor, &m_accumColor, &m_moments, &m_blurTemp, &m_firstHit, &m_histAccum, &m_histMoments, &m_histFirstHit, &m_heatmap})
+      nvvk::cmdBarrierImageLayout(cmdBuf, texture->image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+    clearAccumulation(cmdBuf);
 
     genCmdBuf.submitAndWait(cmdBuf);
   }
 
-
+  createPixelList(size);
   createPostDescriptor();
 }
 
+//--------------------------------------------------------------------------------------------------
+// Full resolution image, only used as storage by the compute and ray tracing passes
+//
+void RenderOutput::createStorage(nvvk::Texture& texture, const VkExtent2D& size, VkFormat format, VkImageUsageFlags usage)
+{
+  if(texture.image != VK_NULL_HANDLE)
+    m_pAlloc->destroy(texture);
+
+  auto createInfo = nvvk::makeImage2DCreateInfo(size, format, usage);
+  setSharing(createInfo);
+
+  nvvk::Image image = m_pAlloc->createImage(createInfo);
+  NAME_VK(image.image);
+  VkImageViewCreateInfo ivInfo   = nvvk::makeImageViewCreateInfo(image.image, createInfo);
+  texture                        = m_pAlloc->createTexture(image, ivInfo);
+  texture.descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Buffers used by the compacted dispatch of the foveated ray tracing: the list can hold
+// all pixels of the image and the arguments are read by vkCmdTraceRaysIndirectKHR
+//
+void RenderOutput::createPixelList(const VkExtent2D& size)
+{
+  m_pAlloc->destroy(m_pixelList);
+  m_pAlloc->destroy(m_traceCmd);
+
+  // An entry packs the coordinates of a pixel in 16 bits each (pixel_select.comp), larger
+  // images would wrap and trace the wrong pixels
+  assert(size.width <= 0xFFFF && size.height <= 0xFFFF);
+  if(size.width > 0xFFFF || size.height > 0xFFFF)
+    LOGE("Image %ux%u too large for the pixel list, at most 65535 pixels per axis\n", size.width, size.height);
+
+  VkDeviceSize listSize = std::max(VkDeviceSize(1), VkDeviceSize(size.width) * size.height) * sizeof(uint32_t);
+  auto listInfo = nvvk::makeBufferCreateInfo(listSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+  setSharing(listInfo);
+  m_pixelList = m_pAlloc->createBuffer(listInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_pixelList.buffer);
+
+  auto cmdInfo = nvvk::makeBufferCreateInfo(sizeof(TraceRaysIndirectCmd),
+                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                                | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+  setSharing(cmdInfo);
+  m_traceCmd = m_pAlloc->createBuffer(cmdInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_traceCmd.buffer);
+  m_traceCmdAddress = nvvk::getBufferDeviceAddress(m_device, m_traceCmd.buffer);
+}
+
 //--------------------------------------------------------------------------------------------------
 // The pipeline is how things are rendered, which shaders, type of primitives, depth test and more
 //
@@ -139,7 +251,7 @@ void RenderOutput::createPostPipeline(const VkRenderPass& renderPass)
   pipelineGenerator.addShader(vertexShader, VK_SHADER_STAGE_VERTEX_BIT);
   pipelineGenerator.addShader(fragShader, VK_SHADER_STAGE_FRAGMENT_BIT);
   pipelineGenerator.rasterizationState.cullMode = VK_CULL_MODE_NONE;
-  CREATE_NAMED_VK(m_postPipeline, pipelineGenerator.createPipeline());
+  CREATE_NAMED_VK(m_postPipeline, pipelineGenerator.createPipeline(m_pipelineCache));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -158,13 +270,36 @@ void RenderOutput::createPostDescriptor()
   bind.addBinding({OutputBindings::eSampler, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT});
   bind.addBinding({OutputBindings::eStore, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1,
                    VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
+  bind.addBinding({OutputBindings::ePixelList, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                   VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
+  bind.addBinding({OutputBindings::eTraceCmd, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  bind.addBinding({OutputBindings::eAccum, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
+  bind.addBinding({OutputBindings::eMoments, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
+  bind.addBinding({OutputBindings::eBlurTemp, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  bind.addBinding({OutputBindings::eFirstHit, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
+  bind.addBinding({OutputBindings::eHistAccum, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  bind.addBinding({OutputBindings::eHistMoments, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  bind.addBinding({OutputBindings::eHistFirstHit, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  bind.addBinding({OutputBindings::eHeatmap, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_RAYGEN_BIT_KHR});
   m_postDescSetLayout = bind.createLayout(m_device);
   m_postDescPool      = bind.createPool(m_device);
   m_postDescSet       = nvvk::allocateDescriptorSet(m_device, m_postDescPool, m_postDescSetLayout);
 
   std::vector<VkWriteDescriptorSet> writes;
   writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eSampler, &m_offscreenColor.descriptor));  // This is use by the tonemapper
-  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eStore, &m_offscreenColor.descriptor));  // This will be used by the ray trace to write the image
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eStore, &m_resultColor.descriptor));  // This will be used by the ray trace to write the image
+  VkDescriptorBufferInfo pixelListDesc{m_pixelList.buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo traceCmdDesc{m_traceCmd.buffer, 0, VK_WHOLE_SIZE};
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::ePixelList, &pixelListDesc));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eTraceCmd, &traceCmdDesc));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eAccum, &m_accumColor.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eMoments, &m_moments.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eBlurTemp, &m_blurTemp.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eFirstHit, &m_firstHit.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eHistAccum, &m_histAccum.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eHistMoments, &m_histMoments.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eHistFirstHit, &m_histFirstHit.descriptor));
+  writes.emplace_back(bind.makeWrite(m_postDescSet, OutputBindings::eHeatmap, &m_heatmap.descriptor));
   vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 }
 
@@ -174,6 +309,7 @@ void RenderOutput::createPostDescriptor()
 void RenderOutput::run(VkCommandBuffer cmdBuf)
 {
   LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
 
   vkCmdPushConstants(cmdBuf, m_postPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Tonemapper), &m_tonemapper);
   vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, m_postPipeline);
@@ -188,6 +324,108 @@ void RenderOutput::run(VkCommandBuffer cmdBuf)
 void RenderOutput::genMipmap(VkCommandBuffer cmdBuf)
 {
   LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
   nvvk::cmdGenerateMipmaps(cmdBuf, m_offscreenColor.image, m_offscreenColorFormat, m_size, nvvk::mipLevels(m_size), 1,
                            VK_IMAGE_LAYOUT_GENERAL);
 }
+
+//--------------------------------------------------------------------------------------------------
+// Copying the completed ray tracing result to the displayed image, on the graphics queue. The
+// trace is synchronized by the semaphores of AsyncCompute, the previous display by this barrier.
+//
+void RenderOutput::resolve(VkCommandBuffer cmdBuf)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkImageCopy region{};
+  region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.extent         = {m_size.width, m_size.height, 1};
+  vkCmdCopyImage(cmdBuf, m_resultColor.image, VK_IMAGE_LAYOUT_GENERAL, m_offscreenColor.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+
+  // Read by the mipmap generation and the tonemapper
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 1, &mb, 0, nullptr, 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Restarting the accumulation: no samples for any pixel, the moments, first hits and heatmap follow
+//
+void RenderOutput::clearAccumulation(VkCommandBuffer cmdBuf)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkClearColorValue       clearColor{{0.f, 0.f, 0.f, 0.f}};
+  VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  vkCmdClearColorImage(cmdBuf, m_accumColor.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+  vkCmdClearColorImage(cmdBuf, m_moments.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+  vkCmdClearColorImage(cmdBuf, m_firstHit.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+  vkCmdClearColorImage(cmdBuf, m_heatmap.image, VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &range);
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Keeping the accumulation of the previous frame aside, the reprojection gathers from the copy
+//
+void RenderOutput::copyHistory(VkCommandBuffer cmdBuf)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkImageCopy region{};
+  region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.extent         = {m_size.width, m_size.height, 1};
+  vkCmdCopyImage(cmdBuf, m_accumColor.image, VK_IMAGE_LAYOUT_GENERAL, m_histAccum.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  vkCmdCopyImage(cmdBuf, m_moments.image, VK_IMAGE_LAYOUT_GENERAL, m_histMoments.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+  vkCmdCopyImage(cmdBuf, m_firstHit.image, VK_IMAGE_LAYOUT_GENERAL, m_histFirstHit.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Linear values of the displayed image (RGBA32F), for saving the result
+//
+void RenderOutput::copyToBuffer(VkCommandBuffer cmdBuf, VkBuffer buffer)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+
+  VkBufferImageCopy region{};
+  region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  region.imageExtent      = {m_size.width, m_size.height, 1};
+  vkCmdCopyImageToBuffer(cmdBuf, m_offscreenColor.image, VK_IMAGE_LAYOUT_GENERAL, buffer, 1, &region);
+
+  mb.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+}
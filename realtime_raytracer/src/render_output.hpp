@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "nvmath/nvmath.h"
 
 #include "nvvk/resourceallocator_vk.hpp"
@@ -41,7 +43,10 @@ public:
       1.0f,          // contrast;
       1.2f,          // saturation;
       1.0f,          // avgLum;
-      1             // autoExposure;
+      1,             // autoExposure;
+      0,             // heatmap, set with the debug view
+      {1.0f, 1.0f},  // uvScale, set for each trace
+      {1.0f, 1.0f},  // uvMax
   };
 
 public:
@@ -49,25 +54,51 @@ public:
   void destroy();
   void create(const VkExtent2D& size, const VkRenderPass& renderPass);
   void update(const VkExtent2D& size);
+  void setPipelineCache(VkPipelineCache cache) { m_pipelineCache = cache; }
+  void setDisplayFamily(uint32_t familyIndex);  // Queue family of the resolve and post, if not the setup one
   void run(VkCommandBuffer cmdBuf);
   void genMipmap(VkCommandBuffer cmdBuf);
+  void resolve(VkCommandBuffer cmdBuf);
+  void clearAccumulation(VkCommandBuffer cmdBuf);
+  void copyHistory(VkCommandBuffer cmdBuf);
+  void copyToBuffer(VkCommandBuffer cmdBuf, VkBuffer buffer);  // Displayed image, RGBA32F
 
   VkDescriptorSetLayout getDescLayout() { return m_postDescSetLayout; }
   VkDescriptorSet       getDescSet() { return m_postDescSet; }
+  VkBuffer              getTraceCmd() { return m_traceCmd.buffer; }
+  VkDeviceAddress       getTraceCmdAddress() { return m_traceCmdAddress; }
 
 private:
   void createOffscreenRender(const VkExtent2D& size);
   void createPostPipeline(const VkRenderPass& renderPass);
   void createPostDescriptor();
+  void createPixelList(const VkExtent2D& size);
+  void createStorage(nvvk::Texture& texture, const VkExtent2D& size, VkFormat format, VkImageUsageFlags usage);
+  template <class CreateInfo>
+  void setSharing(CreateInfo& createInfo) const;
 
   VkDescriptorPool      m_postDescPool{VK_NULL_HANDLE};
   VkDescriptorSetLayout m_postDescSetLayout{VK_NULL_HANDLE};
   VkDescriptorSet       m_postDescSet{VK_NULL_HANDLE};
   VkPipeline            m_postPipeline{VK_NULL_HANDLE};
   VkPipelineLayout      m_postPipelineLayout{VK_NULL_HANDLE};
-  nvvk::Texture         m_offscreenColor;
+  nvvk::Texture         m_offscreenColor;  // Displayed: resolved from m_resultColor, with mipmaps for the auto exposure
+  nvvk::Texture         m_resultColor;     // Written by the ray tracing, copied to the display when complete
+  nvvk::Texture         m_accumColor;  // Running sum (rgb) and per-pixel sample count (a)
+  nvvk::Texture         m_moments;     // Running sum of the squared sample luminance
+  nvvk::Texture         m_blurTemp;    // Horizontal pass of the periphery reconstruction
+  nvvk::Texture         m_firstHit;    // First hit normal (xyz) and distance (w) of the accumulated samples
+  nvvk::Texture         m_histAccum;   // Copies of the previous frame, read by the reprojection
+  nvvk::Texture         m_histMoments;
+  nvvk::Texture         m_histFirstHit;
+  nvvk::Texture         m_heatmap;     // Heatmap debug view: average clock cost (r) and traces averaged (g)
   //VkFormat m_offscreenColorFormat{VkFormat::eR16G16B16A16Sfloat};  // Darkening the scene over 5000 iterations
   VkFormat m_offscreenColorFormat{VK_FORMAT_R32G32B32A32_SFLOAT};
+  VkFormat m_momentsFormat{VK_FORMAT_R32_SFLOAT};
+  VkFormat m_heatmapFormat{VK_FORMAT_R32G32_SFLOAT};
+  nvvk::Buffer          m_pixelList;  // Pixels selected for ray tracing (foveation)
+  nvvk::Buffer          m_traceCmd;   // Indirect launch arguments, see TraceRaysIndirectCmd
+  VkDeviceAddress       m_traceCmdAddress{0};
   VkFormat m_offscreenDepthFormat{VK_FORMAT_X8_D24_UNORM_PACK32};  // Will be replaced by best supported format
 
 
@@ -76,6 +107,8 @@ private:
   nvvk::DebugUtil          m_debug;   // Utility to name objects
   VkDevice                 m_device;
   uint32_t                 m_queueIndex;
+  std::vector<uint32_t>    m_families;  // Queue families using the images and buffers, concurrently if several
+  VkPipelineCache          m_pipelineCache{VK_NULL_HANDLE};
 
   VkExtent2D m_size{};
 };
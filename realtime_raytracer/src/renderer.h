@@ -39,9 +39,19 @@ public:
                                 const VkExtent2D&                   size,
                                 const std::vector<VkDescriptorSet>& extraDescSets) = 0;
   virtual void              create(const VkExtent2D& size, const std::vector<VkDescriptorSetLayout>& extraDescSetsLayout, Scene* _scene = nullptr) = 0;
+  virtual void              update(const VkExtent2D& /*size*/) {}  // The rendering size changed, the device is idle
   virtual const std::string name() = 0;
   void                      setPushContants(const RtxState& state) { m_state = state; }
+  void                      setPipelineCache(VkPipelineCache cache) { m_pipelineCache = cache; }
+  void                      setIndirectArgs(VkBuffer buffer, VkDeviceAddress args)  // Launch over the foveation pixel list
+  {
+    m_indirectBuffer = buffer;
+    m_indirectArgs   = args;
+  }
 
 
-  RtxState m_state{};
+  RtxState        m_state{};
+  VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};   // Shared, persisted on disk
+  VkBuffer        m_indirectBuffer{VK_NULL_HANDLE};  // TraceRaysIndirectCmd
+  VkDeviceAddress m_indirectArgs{0};                 // Its address
 };
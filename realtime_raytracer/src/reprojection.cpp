@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Temporal reprojection of the accumulation, when the camera moved
+ */
+
+
+#include "gpu_profiler.hpp"
+#include "nvvk/shaders_vk.hpp"
+#include "reprojection.hpp"
+#include "tools.hpp"
+
+// Shaders
+#include "autogen/reproject.comp.h"
+
+
+void Reprojection::setup(const VkDevice& device, const VkPhysicalDevice& /*physicalDevice*/, uint32_t /*familyIndex*/, nvvk::ResourceAllocator* /*allocator*/)
+{
+  m_device = device;
+  m_debug.setup(device);
+}
+
+void Reprojection::destroy()
+{
+  vkDestroyPipeline(m_device, m_pipeline, nullptr);
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  m_pipeline       = VkPipeline();
+  m_pipelineLayout = VkPipelineLayout();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The layout is the same as the renderer, the shader uses the output (S_OUT) and the
+// camera (S_SCENE)
+//
+void Reprojection::create(const std::vector<VkDescriptorSetLayout>& descSetLayouts)
+{
+  destroy();
+
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState)};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges    = &pushConstant;
+  pipelineLayoutCreateInfo.setLayoutCount         = static_cast<uint32_t>(descSetLayouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts            = descSetLayouts.data();
+  vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
+
+  VkComputePipelineCreateInfo computePipelineCreateInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+  computePipelineCreateInfo.layout       = m_pipelineLayout;
+  computePipelineCreateInfo.stage        = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  computePipelineCreateInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+  computePipelineCreateInfo.stage.module = nvvk::createShaderModule(m_device, reproject_comp, sizeof(reproject_comp));
+  computePipelineCreateInfo.stage.pName  = "main";
+
+  vkCreateComputePipelines(m_device, m_pipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_pipeline);
+  m_debug.setObjectName(m_pipeline, "Reprojection");
+
+  vkDestroyShaderModule(m_device, computePipelineCreateInfo.stage.module, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Gathering the history at the new pixel positions, before the pixels to trace are selected
+//
+void Reprojection::run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0,
+                          static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState), &m_state);
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+  vkCmdDispatch(cmdBuf, (size.width + (ReprojectBlockSize - 1)) / ReprojectBlockSize,
+                (size.height + (ReprojectBlockSize - 1)) / ReprojectBlockSize, 1);
+
+  // The accumulation is read and written by the pixel selection and the trace
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0, 1, &mb,
+                       0, nullptr, 0, nullptr);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "nvvk/resourceallocator_vk.hpp"
+#include "nvvk/debug_util_vk.hpp"
+
+#include "shaders/host_device.h"
+
+
+/*
+
+Temporal reprojection of the accumulation under camera motion
+* Instead of restarting from no samples when the camera moves, the accumulation of the previous
+  frame is gathered at the pixels seeing the same surfaces (shaders/reproject.comp), using the
+  first hit of the pixels and the previous camera matrices of SceneCamera.
+* History that is not the same surface (depth and normal tolerances) is dropped, here and in the
+  ray generation, which compares with what it actually hits.
+
+* Usage
+  - setup as usual
+  - create, with the same descriptor set layouts as the renderer
+  - run, after RenderOutput::copyHistory and before the pixel selection and the renderer
+*/
+class Reprojection
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator);
+  void destroy();
+  void create(const std::vector<VkDescriptorSetLayout>& descSetLayouts);
+  void run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets);
+  void setPushContants(const RtxState& state) { m_state = state; }
+  void setPipelineCache(VkPipelineCache cache) { m_pipelineCache = cache; }
+
+private:
+  RtxState m_state{};
+
+  // Setup
+  nvvk::DebugUtil m_debug;  // Utility to name objects
+  VkDevice        m_device{VK_NULL_HANDLE};
+  VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+
+  VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+  VkPipeline       m_pipeline{VK_NULL_HANDLE};
+};
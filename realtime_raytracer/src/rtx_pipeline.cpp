@@ -27,6 +27,7 @@
 
 #include <future>
 
+#include "gpu_profiler.hpp"
 #include "nvh/alignment.hpp"
 #include "nvh/fileoperations.hpp"
 #include "nvvk/shaders_vk.hpp"
@@ -52,12 +53,10 @@ void RtxPipeline::setup(const VkDevice& device, const VkPhysicalDevice& physical
   m_debug.setup(device);
 
   // Requesting ray tracing properties
-  VkPhysicalDeviceProperties2                     properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
-  VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_rtProperties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR};
+  VkPhysicalDeviceProperties2 properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+  m_rtProperties   = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR};
   properties.pNext = &m_rtProperties;
   vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
-
-  m_stbWrapper.setup(device, familyIndex, allocator, m_rtProperties);
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -65,13 +64,35 @@ void RtxPipeline::setup(const VkDevice& device, const VkPhysicalDevice& physical
 //
 void RtxPipeline::destroy()
 {
-  m_stbWrapper.destroy();
-
-  vkDestroyPipeline(m_device, m_rtPipeline, nullptr);
+  destroyVariants();
+  vkDestroyPipeline(m_device, m_missLibrary, nullptr);
+  for(auto& lib : m_hitLibraries)
+    vkDestroyPipeline(m_device, lib, nullptr);
   vkDestroyPipelineLayout(m_device, m_rtPipelineLayout, nullptr);
 
+  m_missLibrary      = VkPipeline();
+  m_hitLibraries     = {};
   m_rtPipelineLayout = VkPipelineLayout();
-  m_rtPipeline       = VkPipeline();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Destroy the generic pipeline and all variants, waiting for the one being compiled
+//
+void RtxPipeline::destroyVariants()
+{
+  if(m_building.valid())
+    vkDestroyPipeline(m_device, m_building.get(), nullptr);
+
+  auto destroyVariant = [&](Variant& variant) {
+    unlinkPipeline(variant);
+    vkDestroyPipeline(m_device, variant.raygenLibrary, nullptr);
+    variant.raygenLibrary = VK_NULL_HANDLE;
+  };
+
+  destroyVariant(m_generic);
+  for(auto& v : m_variants)
+    destroyVariant(v.second);
+  m_variants.clear();
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -82,10 +103,14 @@ void RtxPipeline::create(const VkExtent2D& size, const std::vector<VkDescriptorS
   MilliTimer timer;
   LOGI("Create RtxPipeline");
 
-  m_nbHit = 1;  //scene->getStat().nbMaterials;
+  m_nbHit = HitGroupCount;  // One hit group per material class, see AccelStructure::materialHitGroup
 
+  destroy();
   createPipelineLayout(rtDescSetLayouts);
-  createPipeline();
+  createMissLibrary();
+  createHitLibraries();
+  m_generic.raygenLibrary = createRaygenLibrary(nullptr);
+  linkPipeline(m_generic);
   timer.print();
 }
 
@@ -98,7 +123,9 @@ void RtxPipeline::createPipelineLayout(const std::vector<VkDescriptorSetLayout>&
 {
   vkDestroyPipelineLayout(m_device, m_rtPipelineLayout, nullptr);
 
-  VkPushConstantRange pushConstant{VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR,
+  // The any hit reads the ray counter flag
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR
+                                       | VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
                                    0, sizeof(RtxState)};
 
   VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
@@ -111,93 +138,42 @@ void RtxPipeline::createPipelineLayout(const std::vector<VkDescriptorSetLayout>&
 
 
 //--------------------------------------------------------------------------------------------------
-// Pipeline for the ray tracer: all shaders, raygen, chit, miss
+// Settings baked in a variant: see the specialization constants in layouts.glsl
 //
-void RtxPipeline::createPipeline()
+uint32_t RtxPipeline::variantKey(const RtxState& state)
 {
-  vkDestroyPipeline(m_device, m_rtPipeline, nullptr);
-
-  enum StageIndices
-  {
-    eRaygen,
-    eMiss,
-    eMiss2,
-    eClosestHit,
-    eAnyHit,
-    eShaderGroupCount
-  };
-
-  // All stages
-  std::array<VkPipelineShaderStageCreateInfo, eShaderGroupCount> stages{};
-  VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
-  stage.pName = "main";  // All the same entry point
-
-  // Raygen
-  stage.module    = nvvk::createShaderModule(m_device, pathtrace_rgen, sizeof(pathtrace_rgen));
-  stage.stage     = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
-  stages[eRaygen] = stage;
-
-  // Miss
-  stage.module  = nvvk::createShaderModule(m_device, pathtrace_rmiss, sizeof(pathtrace_rmiss));
-  stage.stage   = VK_SHADER_STAGE_MISS_BIT_KHR;
-  stages[eMiss] = stage;
-
-  // The second miss shader is invoked when a shadow ray misses the geometry. It simply indicates that no occlusion has been found
-  stage.module   = nvvk::createShaderModule(m_device, pathtraceShadow_rmiss, sizeof(pathtraceShadow_rmiss));
-  stage.stage    = VK_SHADER_STAGE_MISS_BIT_KHR;
-  stages[eMiss2] = stage;
-
-  // Hit Group - Closest Hit
-  stage.module        = nvvk::createShaderModule(m_device, pathtrace_rchit, sizeof(pathtrace_rchit));
-  stage.stage         = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
-  stages[eClosestHit] = stage;
-
-  // Hit Group - Any Hit
-  stage.module    = nvvk::createShaderModule(m_device, pathtrace_rahit, sizeof(pathtrace_rahit));
-  stage.stage     = VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
-  stages[eAnyHit] = stage;
+  return uint32_t(state.pbrMode) | uint32_t(state.enableFoveation) << 1 | uint32_t(state.maxDepth) << 2;
+}
 
 
-  // Shader groups
-  std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups;
-  VkRayTracingShaderGroupCreateInfoKHR              group{VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR};
-  group.anyHitShader       = VK_SHADER_UNUSED_KHR;
-  group.closestHitShader   = VK_SHADER_UNUSED_KHR;
-  group.generalShader      = VK_SHADER_UNUSED_KHR;
-  group.intersectionShader = VK_SHADER_UNUSED_KHR;
+//--------------------------------------------------------------------------------------------------
+// Interface shared by the libraries and the linked pipelines. The largest payload is PtPayload:
+// 5 scalars, vec2 and two mat4x3 (globals.glsl). The hit attributes are the barycentrics.
+//
+static VkRayTracingPipelineInterfaceCreateInfoKHR pipelineInterface()
+{
+  VkRayTracingPipelineInterfaceCreateInfoKHR info{VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_INTERFACE_CREATE_INFO_KHR};
+  info.maxPipelineRayPayloadSize      = (5 + 2 + 2 * 12) * sizeof(float);
+  info.maxPipelineRayHitAttributeSize = 2 * sizeof(float);
+  return info;
+}
 
-  // Raygen
-  group.type          = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
-  group.generalShader = eRaygen;
-  groups.push_back(group);
+//--------------------------------------------------------------------------------------------------
+// Compiling the stages and groups of a library. All libraries and the linked pipelines share the
+// same layout, recursion depth and payload interface.
+// This can run on a background thread.
+//
+VkPipeline RtxPipeline::createLibrary(const Library& library)
+{
+  VkRayTracingPipelineInterfaceCreateInfoKHR libraryInterface = pipelineInterface();
 
-  // Miss
-  group.type          = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
-  group.generalShader = eMiss;
-  groups.push_back(group);
-
-  // Shadow Miss
-  group.type          = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
-  group.generalShader = eMiss2;
-  groups.push_back(group);
-
-  // closest hit shader
-  group.type             = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
-  group.generalShader    = VK_SHADER_UNUSED_KHR;
-  group.closestHitShader = eClosestHit;
-  if(m_enableAnyhit)
-    group.anyHitShader = eAnyHit;
-  groups.push_back(group);
-
-  // --- Pipeline ---
-  // Assemble the shader stages and recursion depth info into the ray tracing pipeline
   VkRayTracingPipelineCreateInfoKHR rayPipelineInfo{VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR};
-  rayPipelineInfo.stageCount = static_cast<uint32_t>(stages.size());  // Stages are shaders
-  rayPipelineInfo.pStages    = stages.data();
-
-  rayPipelineInfo.groupCount = static_cast<uint32_t>(groups.size());  // 1-raygen, n-miss, n-(hit[+anyhit+intersect])
-  rayPipelineInfo.pGroups    = groups.data();
-
+  rayPipelineInfo.flags                        = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+  rayPipelineInfo.stageCount                   = static_cast<uint32_t>(library.stages.size());
+  rayPipelineInfo.pStages                      = library.stages.data();
+  rayPipelineInfo.groupCount                   = static_cast<uint32_t>(library.groups.size());
+  rayPipelineInfo.pGroups                      = library.groups.data();
+  rayPipelineInfo.pLibraryInterface            = &libraryInterface;
   rayPipelineInfo.maxPipelineRayRecursionDepth = 2;  // Ray depth
   rayPipelineInfo.layout                       = m_rtPipelineLayout;
 
@@ -211,7 +187,8 @@ void RtxPipeline::createPipeline()
     assert(result == VK_SUCCESS);
   }
 
-  vkCreateRayTracingPipelinesKHR(m_device, deferredOp, {}, 1, &rayPipelineInfo, nullptr, &m_rtPipeline);
+  VkPipeline pipeline{VK_NULL_HANDLE};
+  vkCreateRayTracingPipelinesKHR(m_device, deferredOp, m_pipelineCache, 1, &rayPipelineInfo, nullptr, &pipeline);
 
   if(useDeferred)
   {
@@ -240,13 +217,245 @@ void RtxPipeline::createPipeline()
     vkDestroyDeferredOperationKHR(m_device, deferredOp, nullptr);
   }
 
+  // --- Clean up ---
+  for(auto& s : library.stages)
+    vkDestroyShaderModule(m_device, s.module, nullptr);
+
+  return pipeline;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Library with the ray generation, the large shader doing all the shading.
+// With a `variant`, it is specialized on its settings. This can run on a background thread: only
+// the generic library (variant == nullptr) writes the members.
+//
+VkPipeline RtxPipeline::createRaygenLibrary(const RtxState* variant)
+{
+  Library library;
+
+  VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  stage.pName  = "main";
+  stage.module = nvvk::createShaderModule(m_device, pathtrace_rgen, sizeof(pathtrace_rgen));
+  stage.stage  = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+  library.stages.push_back(stage);
+
+  VkRayTracingShaderGroupCreateInfoKHR group{VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR};
+  group.type               = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
+  group.generalShader      = 0;
+  group.anyHitShader       = VK_SHADER_UNUSED_KHR;
+  group.closestHitShader   = VK_SHADER_UNUSED_KHR;
+  group.intersectionShader = VK_SHADER_UNUSED_KHR;
+  library.groups.push_back(group);
+
+  // Specialization of the raygen, the values in the order of SpecConstants
+  std::array<int32_t, 3>                  specValues{};
+  std::array<VkSpecializationMapEntry, 3> specEntries{};
+  VkSpecializationInfo                    specInfo{};
+  if(variant != nullptr)
+  {
+    specValues = {variant->pbrMode, variant->enableFoveation, variant->maxDepth};
+    for(uint32_t i = 0; i < specEntries.size(); i++)
+      specEntries[i] = {i, static_cast<uint32_t>(i * sizeof(int32_t)), sizeof(int32_t)};
+    specInfo.mapEntryCount                 = static_cast<uint32_t>(specEntries.size());
+    specInfo.pMapEntries                   = specEntries.data();
+    specInfo.dataSize                      = sizeof(specValues);
+    specInfo.pData                         = specValues.data();
+    library.stages[0].pSpecializationInfo = &specInfo;
+  }
+
+  VkPipeline pipeline = createLibrary(library);
+
+  if(variant == nullptr)
+  {
+    library.stages[0].module = VK_NULL_HANDLE;
+    m_libraries[eRaygenLibrary] = library;
+  }
+  return pipeline;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Library with the miss shaders: the environment and the shadow miss
+//
+void RtxPipeline::createMissLibrary()
+{
+  Library library;
+
+  VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+  stage.pName = "main";  // All the same entry point
+  stage.stage = VK_SHADER_STAGE_MISS_BIT_KHR;
+
+  // Miss
+  stage.module = nvvk::createShaderModule(m_device, pathtrace_rmiss, sizeof(pathtrace_rmiss));
+  library.stages.push_back(stage);
+
+  // The second miss shader is invoked when a shadow ray misses the geometry. It simply indicates that no occlusion has been found
+  stage.module = nvvk::createShaderModule(m_device, pathtraceShadow_rmiss, sizeof(pathtraceShadow_rmiss));
+  library.stages.push_back(stage);
+
+  VkRayTracingShaderGroupCreateInfoKHR group{VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR};
+  group.type               = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
+  group.anyHitShader       = VK_SHADER_UNUSED_KHR;
+  group.closestHitShader   = VK_SHADER_UNUSED_KHR;
+  group.intersectionShader = VK_SHADER_UNUSED_KHR;
+  for(uint32_t i = 0; i < library.stages.size(); i++)
+  {
+    group.generalShader = i;
+    library.groups.push_back(group);
+  }
+
+  m_missLibrary = createLibrary(library);
+
+  for(auto& s : library.stages)
+    s.module = VK_NULL_HANDLE;
+  m_libraries[eMissLibrary] = library;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Libraries with the hit groups, in the order of the material classes (HitGroup_*). Each class
+// has its closest hit, specialized on the class (constant 0) that it reports for the shading.
+// Only the alpha tested materials have the any hit. One library without and one with it, for
+// toggling the any hit.
+//
+void RtxPipeline::createHitLibraries()
+{
+  std::vector<int32_t> classes(m_nbHit);
+  for(uint32_t hitGroup = 0; hitGroup < m_nbHit; hitGroup++)
+    classes[hitGroup] = static_cast<int32_t>(hitGroup);
+  VkSpecializationMapEntry          specEntry{0, 0, sizeof(int32_t)};
+  std::vector<VkSpecializationInfo> specInfos(m_nbHit);
+  for(uint32_t hitGroup = 0; hitGroup < m_nbHit; hitGroup++)
+    specInfos[hitGroup] = {1, &specEntry, sizeof(int32_t), &classes[hitGroup]};
+
+  for(uint32_t withAnyHit = 0; withAnyHit < 2; withAnyHit++)
+  {
+    Library library;
+
+    VkPipelineShaderStageCreateInfo stage{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+    stage.pName = "main";  // All the same entry point
+
+    // Hit Group - Closest Hit, stage i is the one of the class i
+    for(uint32_t hitGroup = 0; hitGroup < m_nbHit; hitGroup++)
+    {
+      stage.module              = nvvk::createShaderModule(m_device, pathtrace_rchit, sizeof(pathtrace_rchit));
+      stage.stage               = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+      stage.pSpecializationInfo = &specInfos[hitGroup];
+      library.stages.push_back(stage);
+    }
+
+    // Hit Group - Any Hit, after the closest hits
+    const uint32_t anyHit = m_nbHit;
+    if(withAnyHit == 1)
+    {
+      stage.module              = nvvk::createShaderModule(m_device, pathtrace_rahit, sizeof(pathtrace_rahit));
+      stage.stage               = VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+      stage.pSpecializationInfo = nullptr;
+      library.stages.push_back(stage);
+    }
+
+    VkRayTracingShaderGroupCreateInfoKHR group{VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR};
+    group.type               = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
+    group.generalShader      = VK_SHADER_UNUSED_KHR;
+    group.intersectionShader = VK_SHADER_UNUSED_KHR;
+    for(uint32_t hitGroup = 0; hitGroup < m_nbHit; hitGroup++)
+    {
+      group.closestHitShader = hitGroup;
+      group.anyHitShader     = (hitGroup == HitGroup_AlphaMask && withAnyHit == 1) ? anyHit : VK_SHADER_UNUSED_KHR;
+      library.groups.push_back(group);
+    }
+
+    m_hitLibraries[withAnyHit] = createLibrary(library);
+
+    // Same group types in both, the SBT only needs one of them
+    for(auto& s : library.stages)
+    {
+      s.module              = VK_NULL_HANDLE;
+      s.pSpecializationInfo = nullptr;
+    }
+    m_libraries[eHitLibrary] = library;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+// Linking the raygen library of the variant with the miss and hit libraries, and creating its
+// shader binding table (main thread). Linking does not compile the shaders again.
+//
+void RtxPipeline::linkPipeline(Variant& variant)
+{
+  std::array<VkPipeline, eLibraryCount> libraries{};
+  libraries[eRaygenLibrary] = variant.raygenLibrary;
+  libraries[eMissLibrary]   = m_missLibrary;
+  libraries[eHitLibrary]    = m_hitLibraries[m_enableAnyhit ? 1 : 0];
+
+  VkPipelineLibraryCreateInfoKHR libraryInfo{VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR};
+  libraryInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+  libraryInfo.pLibraries   = libraries.data();
+
+  VkRayTracingPipelineInterfaceCreateInfoKHR libraryInterface = pipelineInterface();
+
+  // No stages of its own: 1-raygen, n-miss, n-(hit[+anyhit+intersect]) come from the libraries
+  VkRayTracingPipelineCreateInfoKHR rayPipelineInfo{VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR};
+  rayPipelineInfo.pLibraryInfo                 = &libraryInfo;
+  rayPipelineInfo.pLibraryInterface            = &libraryInterface;
+  rayPipelineInfo.maxPipelineRayRecursionDepth = 2;  // Ray depth
+  rayPipelineInfo.layout                       = m_rtPipelineLayout;
+  vkCreateRayTracingPipelinesKHR(m_device, VK_NULL_HANDLE, m_pipelineCache, 1, &rayPipelineInfo, nullptr, &variant.pipeline);
 
   // --- SBT ---
-  m_stbWrapper.create(m_rtPipeline, rayPipelineInfo);
+  std::vector<VkRayTracingPipelineCreateInfoKHR> librariesInfo;
+  for(auto& lib : m_libraries)
+  {
+    VkRayTracingPipelineCreateInfoKHR info{VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR};
+    info.stageCount = static_cast<uint32_t>(lib.stages.size());
+    info.pStages    = lib.stages.data();
+    info.groupCount = static_cast<uint32_t>(lib.groups.size());
+    info.pGroups    = lib.groups.data();
+    librariesInfo.push_back(info);
+  }
+  variant.sbt = std::make_unique<SBTWrapper>();
+  variant.sbt->setup(m_device, m_queueIndex, m_pAlloc, m_rtProperties);
+  variant.sbt->create(variant.pipeline, rayPipelineInfo, librariesInfo);
+}
 
-  // --- Clean up ---
-  for(auto& s : stages)
-    vkDestroyShaderModule(m_device, s.module, nullptr);
+//--------------------------------------------------------------------------------------------------
+// Destroying the linked pipeline of a variant, its raygen library is kept
+//
+void RtxPipeline::unlinkPipeline(Variant& variant)
+{
+  if(variant.sbt)
+    variant.sbt->destroy();
+  vkDestroyPipeline(m_device, variant.pipeline, nullptr);
+  variant.pipeline = VK_NULL_HANDLE;
+  variant.sbt.reset();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Returns the variant for the current settings if it is compiled, otherwise the generic one.
+// A finished background compilation is swapped in here, and a missing variant is started.
+//
+RtxPipeline::Variant& RtxPipeline::selectVariant()
+{
+  using namespace std::chrono_literals;
+
+  if(m_building.valid() && m_building.wait_for(0s) == std::future_status::ready)
+    m_variants[m_buildingKey].raygenLibrary = m_building.get();
+
+  uint32_t key = variantKey(m_state);
+  auto     it  = m_variants.find(key);
+  if(it != m_variants.end())
+  {
+    // Compiled, only linking it if it is new or after toggling the any hit
+    if(it->second.pipeline == VK_NULL_HANDLE)
+      linkPipeline(it->second);
+    return it->second;
+  }
+
+  // One compilation at a time, the next one starts once this is swapped in
+  if(!m_building.valid())
+  {
+    m_buildingKey = key;
+    m_building    = std::async(std::launch::async, [this, state = m_state]() { return createRaygenLibrary(&state); });
+  }
+  return m_generic;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -255,24 +464,41 @@ void RtxPipeline::createPipeline()
 void RtxPipeline::run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets)
 {
   LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  Variant& variant = selectVariant();
 
-  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rtPipeline);
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, variant.pipeline);
   vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, m_rtPipelineLayout, 0,
                           static_cast<uint32_t>(descSets.size()), descSets.data(), 0, nullptr);
   vkCmdPushConstants(cmdBuf, m_rtPipelineLayout,
-                     VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR,
+                     VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR
+                         | VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
                      0, sizeof(RtxState), &m_state);
 
 
-  auto& regions = m_stbWrapper.getRegions();
-  vkCmdTraceRaysKHR(cmdBuf, &regions[0], &regions[1], &regions[2], &regions[3], size.width, size.height, 1);
+  auto& regions = variant.sbt->getRegions();
+  if(LAUNCH_OVER_PIXEL_LIST(m_state))
+  {
+    // Only the pixels compacted by the selection pass, the launch width is the number of pixels
+    vkCmdTraceRaysIndirectKHR(cmdBuf, &regions[0], &regions[1], &regions[2], &regions[3], m_indirectArgs);
+  }
+  else
+  {
+    vkCmdTraceRaysKHR(cmdBuf, &regions[0], &regions[1], &regions[2], &regions[3], size.width, size.height, 1);
+  }
 }
 
 //--------------------------------------------------------------------------------------------------
-// Toggle the usage of Anyhit. Not having anyhit can be faster, but the scene must but fully opaque
+// Toggle the usage of Anyhit in the alpha mask hit group. Not having anyhit can be faster, but
+// the cutouts and blended materials become opaque. Only linking: the variants are relinked with
+// the other hit library, the generic one now and the others when they are used.
 //
 void RtxPipeline::useAnyHit(bool enable)
 {
   m_enableAnyhit = enable;
-  createPipeline();
+  unlinkPipeline(m_generic);
+  for(auto& v : m_variants)
+    unlinkPipeline(v.second);
+  linkPipeline(m_generic);
 }
@@ -20,6 +20,11 @@
 
 #pragma once
 
+#include <array>
+#include <future>
+#include <map>
+#include <memory>
+
 #include "nvvk/resourceallocator_vk.hpp"
 #include "nvvk/debug_util_vk.hpp"
 #include "nvvk/descriptorsets_vk.hpp"
@@ -38,6 +43,13 @@ Creating the RtCore renderer
   - Acceleration structure (AccelSctruct / Tlas)
   - An image (Post StoreImage)
   - The glTF scene (vertex, index, materials, ... )
+* Pipeline libraries (VK_KHR_pipeline_library): the ray generation, the miss shaders and the hit
+  groups are compiled once as libraries, and the pipelines are only linked from them. Toggling
+  the any hit links the other hit library, without compiling anything.
+* Pipeline variants: the ray generation is specialized on pbrMode, enableFoveation and maxDepth
+  (layouts.glsl), which removes the branches of the other settings. A missing raygen library is
+  compiled on a background thread when the settings change; until it is ready, the generic
+  pipeline, reading the settings from the push constants, is used. Variants are kept until destroy.
 
 * Usage
   - setup as usual
@@ -56,13 +68,55 @@ public:
   const std::string name() override { return std::string("Rtx"); }
 
 private:
-  void createPipeline();
-  void createPipelineLayout(const std::vector<VkDescriptorSetLayout>& rtDescSetLayouts);
+  // Raygen library, and the pipeline linked from it with its shader binding table
+  struct Variant
+  {
+    VkPipeline                  raygenLibrary{VK_NULL_HANDLE};
+    VkPipeline                  pipeline{VK_NULL_HANDLE};
+    std::unique_ptr<SBTWrapper> sbt;
+  };
+
+  // Stages and groups of a library, in the link order
+  enum LibraryIndex
+  {
+    eRaygenLibrary,
+    eMissLibrary,
+    eHitLibrary,
+    eLibraryCount
+  };
+  struct Library
+  {
+    std::vector<VkPipelineShaderStageCreateInfo>      stages;
+    std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups;
+  };
+
+  void       createPipelineLayout(const std::vector<VkDescriptorSetLayout>& rtDescSetLayouts);
+  VkPipeline createLibrary(const Library& library);
+  VkPipeline createRaygenLibrary(const RtxState* variant);
+  void       createMissLibrary();
+  void       createHitLibraries();
+  void       linkPipeline(Variant& variant);
+  void       unlinkPipeline(Variant& variant);
+  void       destroyVariants();
+  Variant&   selectVariant();
+
+  static uint32_t variantKey(const RtxState& state);
 
 
   uint32_t m_nbHit{1};
   bool     m_enableAnyhit{true};
 
+  VkPipeline                m_missLibrary{VK_NULL_HANDLE};
+  std::array<VkPipeline, 2> m_hitLibraries{};  // Without and with the any hit of the alpha mask group
+
+  Variant                     m_generic;   // Not specialized, always available
+  std::map<uint32_t, Variant> m_variants;  // Specialized, by variantKey
+  std::future<VkPipeline>     m_building;  // Raygen library being compiled in the background
+  uint32_t                    m_buildingKey{0};
+
+  // Layout of the libraries, for creating the shader binding tables (the modules are not kept)
+  std::array<Library, eLibraryCount> m_libraries;
+
 private:
   // Setup
   nvvk::ResourceAllocator* m_pAlloc;  // Allocator for buffer, images, acceleration structures
@@ -73,6 +127,4 @@ private:
 
   VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_rtProperties{};
   VkPipelineLayout                                m_rtPipelineLayout{VK_NULL_HANDLE};
-  VkPipeline                                      m_rtPipeline{VK_NULL_HANDLE};
-  SBTWrapper                                      m_stbWrapper;
 };
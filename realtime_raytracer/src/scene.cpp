@@ -115,9 +115,24 @@ bool Scene::load(const std::string& filename)
   m_gltf.m_materials  = gltf.m_materials;
   m_gltf.m_dimensions = gltf.m_dimensions;
 
+  // For the reports, the materials are referred by their index in the shaders
+  m_materialNames.clear();
+  for(const auto& m : tmodel.materials)
+    m_materialNames.push_back(m.name);
+
   return true;
 }
 
+//--------------------------------------------------------------------------------------------------
+// Name of the material for display, its index when it has none
+//
+std::string Scene::getMaterialName(int index) const
+{
+  if(index >= 0 && index < static_cast<int>(m_materialNames.size()) && !m_materialNames[index].empty())
+    return m_materialNames[index];
+  return "Material " + std::to_string(index);
+}
+
 //--------------------------------------------------------------------------------------------------
 //
 //
@@ -648,8 +663,15 @@ void Scene::updateCamera(const VkCommandBuffer& cmdBuf, float aspectRatio)
 {
   const auto& view     = CameraManip.getMatrix();
   const auto  proj     = nvmath::perspectiveVK(CameraManip.getFov(), aspectRatio, 0.001f, 100000.0f);
+
+  // Matrices of the frame before, for the temporal reprojection
+  m_camera.prevViewInverse = m_camera.viewInverse;
+  m_camera.prevProjInverse = m_camera.projInverse;
+  m_camera.prevViewProj    = m_camera.viewProj;
+
   m_camera.viewInverse = nvmath::invert(view);
   m_camera.projInverse = nvmath::invert(proj);
+  m_camera.viewProj    = proj * view;
 
   // Focal is the interest point
   nvmath::vec3f eye, center, up;
@@ -659,13 +681,14 @@ void Scene::updateCamera(const VkCommandBuffer& cmdBuf, float aspectRatio)
   // UBO on the device
   VkBuffer deviceUBO = m_buffer[eCameraMat].buffer;
 
-  // Ensure that the modified UBO is not visible to previous frames.
+  // Ensure that the modified UBO is not visible to previous frames. It is recorded on the compute
+  // queue with the trace, no graphics stages.
   VkBufferMemoryBarrier beforeBarrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
   beforeBarrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
   beforeBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
   beforeBarrier.buffer        = deviceUBO;
   beforeBarrier.size          = sizeof(m_camera);
-  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
                        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_DEPENDENCY_DEVICE_GROUP_BIT, 0, nullptr, 1, &beforeBarrier, 0, nullptr);
 
 
@@ -680,6 +703,6 @@ void Scene::updateCamera(const VkCommandBuffer& cmdBuf, float aspectRatio)
   afterBarrier.buffer        = deviceUBO;
   afterBarrier.size          = sizeof(m_camera);
   vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                       VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
                        VK_DEPENDENCY_DEVICE_GROUP_BIT, 0, nullptr, 1, &afterBarrier, 0, nullptr);
 }
@@ -73,6 +73,7 @@ public:
   nvh::GltfStats&                  getStat() { return m_stats; }
   const std::vector<nvvk::Buffer>& getBuffers(EBuffers b) { return m_buffers[b]; }
   const std::string&               getSceneName() const { return m_sceneName; }
+  std::string                      getMaterialName(int index) const;
   SceneCamera&                     getCamera() { return m_camera; }
 
 private:
@@ -82,8 +83,9 @@ private:
   nvh::GltfScene m_gltf;
   nvh::GltfStats m_stats;
 
-  std::string m_sceneName;
-  SceneCamera m_camera{};
+  std::string              m_sceneName;
+  std::vector<std::string> m_materialNames;  // Names in the glTF, empty when unnamed
+  SceneCamera              m_camera{};
 
   // Setup
   nvvk::ResourceAllocator* m_pAlloc;  // Allocator for buffer, images, acceleration structures
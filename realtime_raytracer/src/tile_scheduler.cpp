@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ *  Splitting the trace in tiles and scheduling them against a GPU time budget per submission,
+ *  the tiles nearest to the fovea first.
+ */
+
+
+#include <algorithm>
+
+#include "shaders/host_device.h"
+#include "tile_scheduler.hpp"
+#include "tools.hpp"
+
+
+void TileScheduler::destroy()
+{
+  m_order.clear();
+  m_next = m_first = m_count = 0;
+  m_pending = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+// All tiles of the region, sorted by the distance of their center to the gaze (normalized)
+//
+void TileScheduler::beginPass(const VkExtent2D& size, const nvmath::vec2f& gaze)
+{
+  if(size.width != m_size.width || size.height != m_size.height)
+    m_tileCost = 0.f;  // Partial tiles on the border changed
+  m_size = size;
+
+  m_order.clear();
+  for(uint32_t y = 0; y < size.height; y += TraceTileSize)
+    for(uint32_t x = 0; x < size.width; x += TraceTileSize)
+      m_order.emplace_back(int(x), int(y));
+
+  nvmath::vec2f fovea(gaze.x * size.width, gaze.y * size.height);
+  auto          distance = [&](const nvmath::vec2i& t) {
+    nvmath::vec2f center(t.x + TraceTileSize * 0.5f, t.y + TraceTileSize * 0.5f);
+    return nvmath::length(center - fovea);
+  };
+  std::stable_sort(m_order.begin(), m_order.end(),
+                   [&](const nvmath::vec2i& a, const nvmath::vec2i& b) { return distance(a) < distance(b); });
+
+  m_next = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+// The cost of the tiles of the previous submission, which is done: a trace is only recorded once
+// the previous one completed (AsyncCompute). The time is the one of its tiles only
+// (AsyncCompute::getTilesTime). It is 0 without timestamps on the queue, the budget then falls
+// back to one tile, or if the previous submission traced no tiles (tiling switched off, nothing
+// to trace): the tiles counted are not the ones of that submission, nothing is measured.
+//
+void TileScheduler::measure(float tilesTime)
+{
+  if(!m_pending)
+    return;
+  m_pending = false;
+  if(tilesTime <= 0.f)
+    return;
+
+  m_lastTime    = tilesTime;
+  float perTile = m_lastTime / float(std::max(m_count, 1u));
+  m_tileCost    = m_tileCost > 0.f ? m_tileCost * 0.75f + perTile * 0.25f : perTile;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Number of tiles to trace in this submission: as many as the budget allows, at least one
+//
+uint32_t TileScheduler::begin(float tilesTime)
+{
+  measure(tilesTime);
+
+  uint32_t remaining = static_cast<uint32_t>(m_order.size()) - m_next;
+  uint32_t count     = 1;
+  if(m_tileCost > 0.f)
+    count = static_cast<uint32_t>(std::max(m_budgetMs / m_tileCost, 1.f));
+  m_first = m_next;
+  m_count = std::min(count, remaining);
+  m_next += m_count;
+  m_pending = true;
+  return m_count;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Tile of this submission, clamped to the region
+//
+VkRect2D TileScheduler::getTile(uint32_t index) const
+{
+  const nvmath::vec2i& origin = m_order[m_first + index];
+  VkRect2D             tile{{origin.x, origin.y}};
+  tile.extent.width  = std::min(uint32_t(TraceTileSize), m_size.width - origin.x);
+  tile.extent.height = std::min(uint32_t(TraceTileSize), m_size.height - origin.y);
+  return tile;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "nvmath/nvmath.h"
+#include "vulkan/vulkan_core.h"
+
+
+/*
+
+Time-budgeted tiled trace
+* The render region is split in square tiles (TraceTileSize). A pass traces every tile once and
+  is what a frame of accumulation was: the frame counter only advances with a new pass.
+* Each trace submission traces the tiles that fit in the budget, the others are carried over to
+  the next submission. The cost of a tile is a running average of the GPU time of the tiles of
+  the previous submission (AsyncCompute::getTilesTime) over their count.
+* The tiles nearest to the fovea are traced first: the order is sorted on the gaze position at
+  the start of the pass.
+
+* Usage
+  - beginPass, when the previous pass is done (isPassDone) or restarted
+  - isPassStart, before begin: the first tiles do the work of the start of the frame
+  - begin, with the GPU time of the tiles of the previous submission: the tiles of this submission
+  - for each tile: getTile
+*/
+class TileScheduler
+{
+public:
+  void destroy();
+
+  void     beginPass(const VkExtent2D& size, const nvmath::vec2f& gaze);
+  uint32_t begin(float tilesTime);
+  VkRect2D getTile(uint32_t index) const;
+
+  bool     isPassDone() const { return m_next >= m_order.size(); }
+  bool     isPassStart() const { return m_next == 0; }  // Before begin: no tile of the pass traced yet
+  uint32_t getTileCount() const { return static_cast<uint32_t>(m_order.size()); }
+  uint32_t getTraced() const { return m_count; }  // Tiles of the last submission
+  float    getTileCost() const { return m_tileCost; }
+  float    getLastTime() const { return m_lastTime; }
+
+  bool  m_enable{false};
+  float m_budgetMs{8.f};  // GPU time of the tiles of a submission
+
+private:
+  void measure(float tilesTime);
+
+  std::vector<nvmath::vec2i> m_order;  // Tile origins, nearest to the fovea first
+  uint32_t                   m_next{0};  // Next tile to trace
+  uint32_t                   m_first{0};
+  uint32_t                   m_count{0};
+  VkExtent2D                 m_size{};
+
+  float m_tileCost{0.f};  // Average GPU time of a tile (ms), 0 until measured
+  float m_lastTime{0.f};  // GPU time of the tiles of the last measured submission (ms)
+  bool  m_pending{false};  // The previous submission traced tiles, its time is not measured yet
+};
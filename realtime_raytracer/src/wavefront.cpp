@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+/*
+ *  Implement the wavefront renderer: kernels communicating through queues of paths
+ */
+
+
+#include <algorithm>
+#include <cstddef>
+
+#include "gpu_profiler.hpp"
+#include "nvvk/shaders_vk.hpp"
+#include "scene.hpp"
+#include "tools.hpp"
+#include "wavefront.hpp"
+
+// Shaders
+#include "autogen/wf_extend.comp.h"
+#include "autogen/wf_generate.comp.h"
+#include "autogen/wf_resolve.comp.h"
+#include "autogen/wf_shade.comp.h"
+#include "autogen/wf_shadow.comp.h"
+
+//--------------------------------------------------------------------------------------------------
+//
+//
+void Wavefront::setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator)
+{
+  m_device     = device;
+  m_pAlloc     = allocator;
+  m_queueIndex = familyIndex;
+  m_debug.setup(device);
+
+  // All queues empty, and no workgroup to consume them
+  for(auto& bounce : m_resetCounters)
+    for(auto& queue : bounce.queue)
+      queue = {0, 0, 1, 1};
+}
+
+//--------------------------------------------------------------------------------------------------
+// Destroy all allocated resources
+//
+void Wavefront::destroy()
+{
+  m_pAlloc->destroy(m_paths);
+  m_pAlloc->destroy(m_queues);
+  m_pAlloc->destroy(m_counters);
+
+  for(auto& p : m_pipelines)
+  {
+    vkDestroyPipeline(m_device, p, nullptr);
+    p = VkPipeline();
+  }
+  vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+  vkDestroyDescriptorPool(m_device, m_descPool, nullptr);
+  vkDestroyDescriptorSetLayout(m_device, m_descSetLayout, nullptr);
+  m_bind.clear();
+
+  m_pipelineLayout = VkPipelineLayout();
+  m_descPool       = VkDescriptorPool();
+  m_descSetLayout  = VkDescriptorSetLayout();
+  m_descSet        = VkDescriptorSet();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Creation of the buffers, the pipelines and their layout
+// The incoming descriptors are: acceleration structure, offscreen image, scene data, hdr.
+// The set of the paths and queues (S_WF) is added after them.
+//
+void Wavefront::create(const VkExtent2D& size, const std::vector<VkDescriptorSetLayout>& descSetLayouts, Scene* scene)
+{
+  MilliTimer timer;
+  LOGI("Create Wavefront Pipelines");
+
+  m_bind.addBinding({WavefrontBindings::eWfPaths, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  m_bind.addBinding({WavefrontBindings::eWfQueues, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  m_bind.addBinding({WavefrontBindings::eWfCounters, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT});
+  m_descPool = m_bind.createPool(m_device, 1);
+  CREATE_NAMED_VK(m_descSetLayout, m_bind.createLayout(m_device));
+  CREATE_NAMED_VK(m_descSet, nvvk::allocateDescriptorSet(m_device, m_descPool, m_descSetLayout));
+
+  createBuffers(size);
+
+  std::vector<VkDescriptorSetLayout> layouts = descSetLayouts;
+  layouts.push_back(m_descSetLayout);  // S_WF
+
+  VkPushConstantRange pushConstant{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState) + sizeof(WfStep)};
+
+  VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+  pipelineLayoutCreateInfo.pPushConstantRanges    = &pushConstant;
+  pipelineLayoutCreateInfo.setLayoutCount         = static_cast<uint32_t>(layouts.size());
+  pipelineLayoutCreateInfo.pSetLayouts            = layouts.data();
+  vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &m_pipelineLayout);
+
+  struct KernelCode
+  {
+    const uint32_t* code;
+    size_t          size;
+    const char*     name;
+  };
+  std::array<KernelCode, eNbKernels> kernels{{{wf_generate_comp, sizeof(wf_generate_comp), "WfGenerate"},
+                                              {wf_extend_comp, sizeof(wf_extend_comp), "WfExtend"},
+                                              {wf_shade_comp, sizeof(wf_shade_comp), "WfShade"},
+                                              {wf_shadow_comp, sizeof(wf_shadow_comp), "WfShadow"},
+                                              {wf_resolve_comp, sizeof(wf_resolve_comp), "WfResolve"}}};
+
+  for(int k = 0; k < eNbKernels; k++)
+  {
+    VkComputePipelineCreateInfo computePipelineCreateInfo{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    computePipelineCreateInfo.layout       = m_pipelineLayout;
+    computePipelineCreateInfo.stage        = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+    computePipelineCreateInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    computePipelineCreateInfo.stage.module = nvvk::createShaderModule(m_device, kernels[k].code, kernels[k].size);
+    computePipelineCreateInfo.stage.pName  = "main";
+
+    vkCreateComputePipelines(m_device, m_pipelineCache, 1, &computePipelineCreateInfo, nullptr, &m_pipelines[k]);
+    m_debug.setObjectName(m_pipelines[k], kernels[k].name);
+
+    vkDestroyShaderModule(m_device, computePipelineCreateInfo.stage.module, nullptr);
+  }
+  timer.print();
+}
+
+//--------------------------------------------------------------------------------------------------
+// The paths and queues hold all pixels of the image, the device is idle when resizing
+//
+void Wavefront::update(const VkExtent2D& size)
+{
+  if(m_descSet != VK_NULL_HANDLE)
+    createBuffers(size);
+}
+
+//--------------------------------------------------------------------------------------------------
+// One path and a slot in each queue region per pixel, the counters of all bounces
+//
+void Wavefront::createBuffers(const VkExtent2D& size)
+{
+  m_pAlloc->destroy(m_paths);
+  m_pAlloc->destroy(m_queues);
+  m_pAlloc->destroy(m_counters);
+
+  VkDeviceSize capacity = std::max(VkDeviceSize(1), VkDeviceSize(size.width) * size.height);
+  m_paths  = m_pAlloc->createBuffer(capacity * sizeof(WfPath), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  m_queues = m_pAlloc->createBuffer(capacity * WfQueueRegions * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  m_counters = m_pAlloc->createBuffer(sizeof(m_resetCounters),
+                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  NAME_VK(m_paths.buffer);
+  NAME_VK(m_queues.buffer);
+  NAME_VK(m_counters.buffer);
+
+  std::vector<VkWriteDescriptorSet> writes;
+  VkDescriptorBufferInfo            pathsDesc{m_paths.buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo            queuesDesc{m_queues.buffer, 0, VK_WHOLE_SIZE};
+  VkDescriptorBufferInfo            countersDesc{m_counters.buffer, 0, VK_WHOLE_SIZE};
+  writes.emplace_back(m_bind.makeWrite(m_descSet, WavefrontBindings::eWfPaths, &pathsDesc));
+  writes.emplace_back(m_bind.makeWrite(m_descSet, WavefrontBindings::eWfQueues, &queuesDesc));
+  writes.emplace_back(m_bind.makeWrite(m_descSet, WavefrontBindings::eWfCounters, &countersDesc));
+  vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Ray tracing the scene, one sample of all pixels per pass:
+// - the counters are reset, the generation fills the extension queue of the first bounce
+// - per bounce: extension rays, shading, shadow rays, each on the queue filled by the previous
+// - the samples of the pixels are accumulated at the end
+//
+void Wavefront::run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets)
+{
+  LABEL_SCOPE_VK(cmdBuf);
+  PROFILE_SCOPE_VK(cmdBuf);
+
+  std::vector<VkDescriptorSet> sets = descSets;
+  sets.push_back(m_descSet);  // S_WF
+  vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, static_cast<uint32_t>(sets.size()),
+                          sets.data(), 0, nullptr);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(RtxState), &m_state);
+
+  // Adaptive sampling can boost the samples of the noisy pixels, the others stop earlier
+  int maxDepth = std::min(m_state.maxDepth, WfMaxBounces);
+  int nbPasses = m_state.maxSamples;
+  if(m_state.enableAdaptiveSampling == 1)
+    nbPasses *= std::max(m_state.maxSampleBoost, 1);
+
+  for(int smpl = 0; smpl < nbPasses; smpl++)
+  {
+    barrier(cmdBuf);
+    vkCmdUpdateBuffer(cmdBuf, m_counters.buffer, 0, sizeof(m_resetCounters), m_resetCounters.data());
+    barrier(cmdBuf);
+    dispatchPaths(cmdBuf, size, eGenerate, {smpl, 0});
+
+    for(int bounce = 0; bounce < maxDepth; bounce++)
+    {
+      barrier(cmdBuf);
+      dispatchQueue(cmdBuf, eExtend, {smpl, bounce}, WfQueue_Extend);
+      barrier(cmdBuf);
+      dispatchQueue(cmdBuf, eShade, {smpl, bounce}, WfQueue_Hit);
+      barrier(cmdBuf);
+      dispatchQueue(cmdBuf, eShadow, {smpl, bounce}, WfQueue_Shadow);
+    }
+  }
+
+  barrier(cmdBuf);
+  dispatchPaths(cmdBuf, size, eResolve, {nbPasses, 0});
+}
+
+//--------------------------------------------------------------------------------------------------
+// One invocation per traced pixel: the pixels of the image, or the compacted list whose
+// workgroup count is written by the selection pass
+//
+void Wavefront::dispatchPaths(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, Kernels kernel, const WfStep& step)
+{
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[kernel]);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(RtxState), sizeof(WfStep), &step);
+
+  if(LAUNCH_OVER_PIXEL_LIST(m_state))
+    vkCmdDispatchIndirect(cmdBuf, m_indirectBuffer, offsetof(TraceRaysIndirectCmd, dispatchX));
+  else
+    vkCmdDispatch(cmdBuf, (size.width * size.height + (WfBlockSize - 1)) / WfBlockSize, 1, 1);
+}
+
+//--------------------------------------------------------------------------------------------------
+// One invocation per path in the queue of the bounce, the workgroup count is written by the
+// kernel that filled it
+//
+void Wavefront::dispatchQueue(const VkCommandBuffer& cmdBuf, Kernels kernel, const WfStep& step, int queue)
+{
+  vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelines[kernel]);
+  vkCmdPushConstants(cmdBuf, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, sizeof(RtxState), sizeof(WfStep), &step);
+
+  VkDeviceSize offset = step.bounce * sizeof(WfBounceCounters) + queue * sizeof(WfQueueCounter) + offsetof(WfQueueCounter, dispatchX);
+  vkCmdDispatchIndirect(cmdBuf, m_counters.buffer, offset);
+}
+
+//--------------------------------------------------------------------------------------------------
+// Each kernel, and the reset of the counters, sees the paths, queues and counters written before
+//
+void Wavefront::barrier(const VkCommandBuffer& cmdBuf)
+{
+  VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  mb.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+                     | VK_ACCESS_TRANSFER_WRITE_BIT;
+  vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       0, 1, &mb, 0, nullptr, 0, nullptr);
+}
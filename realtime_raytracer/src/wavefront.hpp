@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-FileCopyrightText: Copyright (c) 2021 NVIDIA CORPORATION
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+
+#include "nvvk/resourceallocator_vk.hpp"
+#include "nvvk/debug_util_vk.hpp"
+#include "nvvk/descriptorsets_vk.hpp"
+
+#include "renderer.h"
+#include "shaders/host_device.h"
+
+
+/*
+
+Creating the wavefront renderer: the path tracer split in compute kernels, tracing with ray queries
+* Requiring:
+  - Acceleration structure (AccelSctruct / Tlas)
+  - An image (Post StoreImage)
+  - The glTF scene (vertex, index, materials, ... )
+* Kernels (shaders/wf_*.comp), all on the pipeline layout extended with its set (S_WF):
+  - Generate: camera rays of the pixels, once per sample pass
+  - Extend: closest hit of the rays, hits to the shading queue
+  - Shade: material, light sampling, next ray; shadow rays and continuing paths to their queues
+  - Shadow: visibility of the light contribution
+  - Resolve: accumulation of the pixel samples
+* The kernels after the generation are launched indirectly, on the number of paths each queue
+  received (WfBounceCounters), the workgroups of the terminated paths are not launched.
+
+* Usage
+  - setup as usual
+  - create
+  - update when the size changes
+  - run
+*/
+class Wavefront : public Renderer
+{
+public:
+  void setup(const VkDevice& device, const VkPhysicalDevice& physicalDevice, uint32_t familyIndex, nvvk::ResourceAllocator* allocator) override;
+  void destroy() override;
+  void create(const VkExtent2D& size, const std::vector<VkDescriptorSetLayout>& descSetLayouts, Scene* scene) override;
+  void update(const VkExtent2D& size) override;
+  void run(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, const std::vector<VkDescriptorSet>& descSets) override;
+
+  const std::string name() override { return std::string("WF"); }
+
+private:
+  enum Kernels
+  {
+    eGenerate,
+    eExtend,
+    eShade,
+    eShadow,
+    eResolve,
+    eNbKernels
+  };
+
+  void createBuffers(const VkExtent2D& size);
+  void dispatchPaths(const VkCommandBuffer& cmdBuf, const VkExtent2D& size, Kernels kernel, const WfStep& step);
+  void dispatchQueue(const VkCommandBuffer& cmdBuf, Kernels kernel, const WfStep& step, int queue);
+  void barrier(const VkCommandBuffer& cmdBuf);
+
+  // Setup
+  nvvk::ResourceAllocator* m_pAlloc;  // Allocator for buffer, images, acceleration structures
+  nvvk::DebugUtil          m_debug;   // Utility to name objects
+  VkDevice                 m_device;
+  uint32_t                 m_queueIndex{0};
+
+  // Paths, queues and counters (S_WF)
+  nvvk::Buffer                m_paths;
+  nvvk::Buffer                m_queues;
+  nvvk::Buffer                m_counters;
+  VkDescriptorPool            m_descPool{VK_NULL_HANDLE};
+  VkDescriptorSetLayout       m_descSetLayout{VK_NULL_HANDLE};
+  VkDescriptorSet             m_descSet{VK_NULL_HANDLE};
+  nvvk::DescriptorSetBindings m_bind;
+
+  VkPipelineLayout                           m_pipelineLayout{VK_NULL_HANDLE};
+  std::array<VkPipeline, eNbKernels>         m_pipelines{};
+  std::array<WfBounceCounters, WfMaxBounces> m_resetCounters{};  // Empty queues, uploaded before each sample pass
+};